@@ -0,0 +1,113 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+
+/* encodes and decodes the fixes parsed from each file given on the command
+ * line and reports the bytes per fix and the encode/decode throughput in MB/s
+ * of gpsdata_fix_t records */
+
+#define BENCH_CODEC_ROUNDS 200
+
+static int bench_codec_file(const char *path, uint32_t restart_interval)
+{
+    gpsdata_list_t list;
+    gpsdata_list_init(&list);
+    if (gpsdata_parse_file_parallel(path, 1, &list, NULL) < 0 || list.count == 0) {
+        GPSUTILS_ERROR("No fixes parsed from %s\n", path);
+        gpsdata_list_clear(&list);
+        return -1;
+    }
+    size_t count = list.count;
+    gpsdata_fix_t *fixes = calloc(count, sizeof(*fixes));
+    gpsdata_fix_t *decoded = calloc(count, sizeof(*decoded));
+    uint8_t *buf = calloc(count, GPSDATA_CODEC_MAX_RECORD);
+    if (!fixes || !decoded || !buf) {
+        GPSUTILS_ERROR_NOMEM(count * GPSDATA_CODEC_MAX_RECORD);
+        GPSUTILS_FREE(fixes);
+        GPSUTILS_FREE(decoded);
+        GPSUTILS_FREE(buf);
+        gpsdata_list_clear(&list);
+        return -1;
+    }
+    size_t idx = 0;
+    const gpsdata_data_t *item = NULL;
+    LL_FOREACH(list.head, item) {
+        gpsdata_fix_from_data(&fixes[idx++], item);
+    }
+    gpsdata_list_clear(&list);
+
+    int rc = 0;
+    size_t len = 0;
+    gpsutils_timer_t enc_tt, dec_tt;
+    gpsdata_codec_t codec;
+    gpsutils_timer_start(&enc_tt);
+    for (int r = 0; r < BENCH_CODEC_ROUNDS && rc == 0; ++r) {
+        gpsdata_codec_init(&codec, restart_interval);
+        len = 0;
+        for (size_t i = 0; i < count; ++i) {
+            int n = gpsdata_codec_encode(&codec, &fixes[i], buf + len,
+                        count * GPSDATA_CODEC_MAX_RECORD - len, NULL);
+            if (n <= 0) {
+                rc = -1;
+                break;
+            }
+            len += (size_t)n;
+        }
+    }
+    gpsutils_timer_stop(&enc_tt);
+    gpsutils_timer_start(&dec_tt);
+    for (int r = 0; r < BENCH_CODEC_ROUNDS && rc == 0; ++r) {
+        gpsdata_codec_init(&codec, restart_interval);
+        size_t off = 0;
+        for (size_t i = 0; i < count; ++i) {
+            int n = gpsdata_codec_decode(&codec, buf + off, len - off, &decoded[i]);
+            if (n <= 0) {
+                rc = -1;
+                break;
+            }
+            off += (size_t)n;
+        }
+    }
+    gpsutils_timer_stop(&dec_tt);
+    for (size_t i = 0; i < count && rc == 0; ++i) {
+        if (decoded[i].timestamp_usec != fixes[i].timestamp_usec ||
+            decoded[i].latitude_e7 != fixes[i].latitude_e7 ||
+            decoded[i].longitude_e7 != fixes[i].longitude_e7 ||
+            decoded[i].msgid != fixes[i].msgid) {
+            GPSUTILS_ERROR("Fix %zu of %s did not round trip\n", i, path);
+            rc = -1;
+        }
+    }
+    if (rc == 0) {
+        double mb = (double)(count * sizeof(gpsdata_fix_t) * BENCH_CODEC_ROUNDS) / 1e6;
+        printf("%s: %zu fixes, %.2f bytes/fix (binlog %zu, raw %zu), "
+                "encode %.1f MB/s, decode %.1f MB/s\n", path, count,
+                (double)len / (double)count, sizeof(gpsdata_binlog_record_t),
+                sizeof(gpsdata_fix_t), mb / enc_tt.time_taken,
+                mb / dec_tt.time_taken);
+    } else {
+        GPSUTILS_ERROR("Codec failed on %s\n", path);
+    }
+    GPSUTILS_FREE(fixes);
+    GPSUTILS_FREE(decoded);
+    GPSUTILS_FREE(buf);
+    return rc;
+}
+
+int main(int argc, char **argv)
+{
+    int rc = 0;
+    GPSUTILS_LOGLEVEL_SET(WARN);
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <nmea file>...\n", argv[0]);
+        return 1;
+    }
+    for (int i = 1; i < argc; ++i) {
+        if (bench_codec_file(argv[i], GPSDATA_CODEC_DEFAULT_RESTART) < 0)
+            rc = 1;
+    }
+    return rc;
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsconfig.h>
+#include <gpsdata.h>
+#ifdef LIBGPS_MTK3339_HAVE_SYS_RESOURCE_H
+    #include <sys/resource.h>
+#endif
+
+/* benchmarks gpsdata_parser_parse_list() on a corpus of each sentence type
+ * and on a mixed corpus fed in chunks of 1 byte to 64 KiB. Each benchmark
+ * reports MB/s, ns/sentence, heap allocations/sentence and the peak RSS of
+ * the process so far. With -o the results are also written as JSON. */
+
+#define BENCH_PARSER_CORPUS_SIZE (1024 * 1024)
+#define BENCH_PARSER_MIN_NSEC 200000000LL
+#define BENCH_PARSER_MAX_ROUNDS 1000
+
+/** NOTE: the allocation counters interpose the allocator on glibc, which
+ * exports its implementation as __libc_malloc() and friends. Elsewhere the
+ * allocations are reported as -1 **/
+#ifdef __GLIBC__
+    #define BENCH_PARSER_COUNT_ALLOCS 1
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void __libc_free(void *);
+
+static bool bench_alloc_enabled = false;
+static uint64_t bench_alloc_count = 0;
+
+void *malloc(size_t sz)
+{
+    if (bench_alloc_enabled)
+        bench_alloc_count++;
+    return __libc_malloc(sz);
+}
+
+void *calloc(size_t n, size_t sz)
+{
+    if (bench_alloc_enabled)
+        bench_alloc_count++;
+    return __libc_calloc(n, sz);
+}
+
+void *realloc(void *p, size_t sz)
+{
+    if (bench_alloc_enabled)
+        bench_alloc_count++;
+    return __libc_realloc(p, sz);
+}
+
+void free(void *p)
+{
+    __libc_free(p);
+}
+#endif
+
+typedef struct {
+    const char *name;
+    const char *sentences;
+} bench_parser_corpus_t;
+
+static const bench_parser_corpus_t bench_parser_sentences[] = {
+    { "GGA", "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n" },
+    { "RMC", "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n" },
+    { "VTG", "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n" },
+    { "GSA", "$GPGSA,A,3,29,21,26,15,18,09,06,10,,,,,2.32,0.95,2.11*00\r\n" },
+    { "GSV", "$GPGSV,2,1,07,21,67,278,18,15,66,048,38,20,46,302,26,24,38,154,13*72\r\n"
+             "$GPGSV,2,2,07,13,33,048,22,10,19,289,17,41,,,*79\r\n" },
+    { "PGTOP", "$PGTOP,11,3*6F\r\n" },
+    { "PMTK705", "$PMTK705,AXN_2.31_3339_13101700,5632,PA6H,1.0*6B\r\n" }
+};
+#define BENCH_PARSER_SENTENCES \
+    (sizeof(bench_parser_sentences) / sizeof(bench_parser_sentences[0]))
+
+// one second of output of a receiver at the default settings
+static const char *bench_parser_mixed =
+    "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+    "$GPGSA,A,3,29,21,26,15,18,09,06,10,,,,,2.32,0.95,2.11*00\r\n"
+    "$GPGSV,2,1,07,21,67,278,18,15,66,048,38,20,46,302,26,24,38,154,13*72\r\n"
+    "$GPGSV,2,2,07,13,33,048,22,10,19,289,17,41,,,*79\r\n"
+    "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+    "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n"
+    "$PGTOP,11,3*6F\r\n";
+
+static const size_t bench_parser_chunks[] = {
+    1, 16, 64, 256, 1024, 4096, 16384, 65536
+};
+#define BENCH_PARSER_CHUNKS \
+    (sizeof(bench_parser_chunks) / sizeof(bench_parser_chunks[0]))
+
+typedef struct {
+    char name[32];
+    size_t chunk;
+    size_t bytes; // per round
+    size_t sentences; // per round
+    size_t items; // per round
+    size_t rounds;
+    double mbps;
+    double ns_per_sentence;
+    double allocs_per_sentence;
+    long peak_rss_kb;
+} bench_parser_result_t;
+
+static int64_t bench_parser_now_ns(void)
+{
+    struct timespec ts = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long bench_parser_peak_rss_kb(void)
+{
+#ifdef LIBGPS_MTK3339_HAVE_SYS_RESOURCE_H
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        return ru.ru_maxrss;
+#endif
+    return -1;
+}
+
+// repeats the sentences until the corpus is BENCH_PARSER_CORPUS_SIZE long
+static char *bench_parser_corpus(const char *sentences, size_t *len, size_t *count)
+{
+    size_t slen = strlen(sentences);
+    size_t reps = (BENCH_PARSER_CORPUS_SIZE + slen - 1) / slen;
+    char *buf = malloc(reps * slen);
+    if (!buf) {
+        GPSUTILS_ERROR_NOMEM(reps * slen);
+        return NULL;
+    }
+    size_t per = 0;
+    for (const char *p = sentences; *p; ++p)
+        per += (*p == '$') ? 1 : 0;
+    for (size_t i = 0; i < reps; ++i)
+        memcpy(buf + i * slen, sentences, slen);
+    *len = reps * slen;
+    *count = reps * per;
+    return buf;
+}
+
+static int bench_parser_run(const char *name, const char *sentences, size_t chunk,
+            bench_parser_result_t *res)
+{
+    size_t len = 0;
+    size_t count = 0;
+    char *buf = bench_parser_corpus(sentences, &len, &count);
+    if (!buf)
+        return -1;
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    if (!fsm) {
+        free(buf);
+        return -1;
+    }
+    memset(res, 0, sizeof(*res));
+    snprintf(res->name, sizeof(res->name), "%s", name);
+    res->chunk = chunk;
+    res->bytes = len;
+    res->sentences = count;
+    int rc = 0;
+    int64_t elapsed = 0;
+    uint64_t allocs = 0;
+    gpsdata_list_t list;
+    gpsdata_list_init(&list);
+    while (rc == 0 && res->rounds < BENCH_PARSER_MAX_ROUNDS &&
+            elapsed < BENCH_PARSER_MIN_NSEC) {
+        size_t items = 0;
+#ifdef BENCH_PARSER_COUNT_ALLOCS
+        bench_alloc_count = 0;
+        bench_alloc_enabled = true;
+#endif
+        int64_t start = bench_parser_now_ns();
+        for (size_t off = 0; off < len; off += chunk) {
+            size_t num = 0;
+            size_t n = (len - off < chunk) ? len - off : chunk;
+            if (gpsdata_parser_parse_list(fsm, buf + off, n, &list, &num) < 0) {
+                GPSUTILS_ERROR("Failed to parse the %s corpus at %zu\n", name, off);
+                rc = -1;
+                break;
+            }
+            items += num;
+            // hand the items back so the pool does not grow with the corpus
+            if (list.count > 256)
+                gpsdata_list_clear(&list);
+        }
+        gpsdata_list_clear(&list);
+        elapsed += bench_parser_now_ns() - start;
+#ifdef BENCH_PARSER_COUNT_ALLOCS
+        bench_alloc_enabled = false;
+        allocs += bench_alloc_count;
+#endif
+        res->items = items;
+        res->rounds++;
+    }
+    if (rc == 0) {
+        double total_bytes = (double)len * (double)res->rounds;
+        double total_sentences = (double)count * (double)res->rounds;
+        res->mbps = (total_bytes / 1e6) / ((double)elapsed / 1e9);
+        res->ns_per_sentence = (double)elapsed / total_sentences;
+#ifdef BENCH_PARSER_COUNT_ALLOCS
+        res->allocs_per_sentence = (double)allocs / total_sentences;
+#else
+        (void)allocs;
+        res->allocs_per_sentence = -1.0;
+#endif
+        res->peak_rss_kb = bench_parser_peak_rss_kb();
+    }
+    gpsdata_parser_free(fsm);
+    free(buf);
+    return rc;
+}
+
+static void bench_parser_print(const bench_parser_result_t *res)
+{
+    printf("%-8s chunk %6zu: %8.2f MB/s %8.1f ns/sentence %6.3f allocs/sentence "
+            "%6ld KiB peak RSS\n", res->name, res->chunk, res->mbps,
+            res->ns_per_sentence, res->allocs_per_sentence, res->peak_rss_kb);
+}
+
+static void bench_parser_json(FILE *fp, const bench_parser_result_t *res,
+            size_t num)
+{
+    fprintf(fp, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < num; ++i) {
+        fprintf(fp, "    { \"name\": \"%s\", \"chunk\": %zu, \"bytes\": %zu, "
+                "\"sentences\": %zu, \"items\": %zu, \"rounds\": %zu, "
+                "\"mb_per_sec\": %.3f, \"ns_per_sentence\": %.2f, "
+                "\"allocs_per_sentence\": %.4f, \"peak_rss_kb\": %ld }%s\n",
+                res[i].name, res[i].chunk, res[i].bytes, res[i].sentences,
+                res[i].items, res[i].rounds, res[i].mbps, res[i].ns_per_sentence,
+                res[i].allocs_per_sentence, res[i].peak_rss_kb,
+                (i + 1 < num) ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *json = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:h")) != -1) {
+        switch (opt) {
+        case 'o':
+            json = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-o results.json]\n", argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+    GPSUTILS_LOGLEVEL_SET(WARN);
+    bench_parser_result_t results[BENCH_PARSER_SENTENCES + BENCH_PARSER_CHUNKS];
+    size_t num = 0;
+    int rc = 0;
+    for (size_t i = 0; i < BENCH_PARSER_SENTENCES; ++i) {
+        if (bench_parser_run(bench_parser_sentences[i].name,
+                    bench_parser_sentences[i].sentences, 4096, &results[num]) < 0) {
+            rc = 1;
+            continue;
+        }
+        bench_parser_print(&results[num++]);
+    }
+    for (size_t i = 0; i < BENCH_PARSER_CHUNKS; ++i) {
+        if (bench_parser_run("mixed", bench_parser_mixed, bench_parser_chunks[i],
+                    &results[num]) < 0) {
+            rc = 1;
+            continue;
+        }
+        bench_parser_print(&results[num++]);
+    }
+    if (json) {
+        FILE *fp = fopen(json, "w");
+        if (!fp) {
+            int err = errno;
+            GPSUTILS_ERROR("Unable to open %s. Error: %s(%d)\n", json,
+                    strerror(err), err);
+            return 1;
+        }
+        bench_parser_json(fp, results, num);
+        fclose(fp);
+    }
+    return rc;
+}
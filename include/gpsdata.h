@@ -26,6 +26,11 @@ typedef enum {
 
 const char *gpsdata_msgid_tostring(gpsdata_msgid_t);
 
+#define GPSDATA_MSGID_COUNT (GPSDATA_MSGID_PMTK + 1)
+// the bit of a message ID in a message filter mask
+#define GPSDATA_MSGID_MASK(A) (UINT32_C(1) << (A))
+#define GPSDATA_MSGID_MASK_ALL UINT32_C(0xFFFFFFFF)
+
 typedef enum {
     GPSDATA_DIRECTION_UNSET = 0, // b0000 (binary)
     GPSDATA_DIRECTION_NORTH = 1, // b0001
@@ -74,6 +79,14 @@ typedef struct {
     float minutes;
 } gpsdata_latlon_t;
 
+// returns the signed degrees (south/west negative) or NAN if direction is unset
+double gpsdata_latlon_to_degrees(const gpsdata_latlon_t *);
+
+// fixed-point values that are not available are set to this
+#define GPSDATA_FIXED_UNSET INT32_MIN
+// returns value / scale, or NAN if the value is GPSDATA_FIXED_UNSET
+double gpsdata_fixed_to_double(int32_t value, int32_t scale);
+
 typedef struct {
     char *firmware;
     char *build_id;
@@ -81,6 +94,24 @@ typedef struct {
     char *chip_version;
 } gpsdata_firmware_t;
 
+// dilution of precision. NAN if not available
+typedef struct {
+    float pdop; // position, from GPGSA
+    float hdop; // horizontal, from GPGGA or GPGSA
+    float vdop; // vertical, from GPGSA
+} gpsdata_dop_t;
+
+// GPGSA: the satellites used in the solution. num_used is 0 if not available
+#define GPSDATA_GSA_SATS_MAX 12
+typedef struct {
+    gpsdata_mode_t selection; // GPSDATA_MODE_MANUAL or GPSDATA_MODE_AUTOMATIC
+    gpsdata_mode_t fix; // GPSDATA_MODE_NOFIX, GPSDATA_MODE_2DFIX or GPSDATA_MODE_3DFIX
+    uint8_t num_used;
+    uint8_t satellites_used[GPSDATA_GSA_SATS_MAX]; // satellite IDs, empty channels skipped
+} gpsdata_gsa_t;
+
+typedef struct gpsdata_pool_t gpsdata_pool_t;
+
 typedef struct gpsdata_data {
     gpsdata_msgid_t msgid;      // the message ID this update is from
     gpsdata_latlon_t latitude;
@@ -97,11 +128,27 @@ typedef struct gpsdata_data {
     float speed_knots;
     float course_degrees;
     float heading_degrees;
+    // exact fixed-point copies of the above, GPSDATA_FIXED_UNSET if not available
+    int32_t latitude_e7; // signed degrees in units of 1e-7, south is negative
+    int32_t longitude_e7; // signed degrees in units of 1e-7, west is negative
+    int32_t altitude_mm;
+    int32_t speed_mmps; // speed over ground in mm/s
+    gpsdata_dop_t dop;
+    gpsdata_gsa_t gsa; // set for GPGSA
+    // GPSDATA_MSGID_MASK() of the messages merged into this item by epoch
+    // fusion. 0 if the item is from a single message
+    uint32_t fused_msgids;
+    // host time in microseconds the leading '$' arrived, 0 if unknown. see
+    // gpsdata_parser_set_rx_time()
+    int64_t rx_usec;
     // antenna status
     gpsdata_antenna_t antenna_status;
     // firmware object. if the user requests firmware this will be filled up and
     // the msgid will be GPSDATA_MSGID_PMTK
     gpsdata_firmware_t fwinfo;
+    // the pool this item was drawn from. NULL if it was allocated on the heap.
+    // gpsdata_list_free() uses this to return the item to its pool
+    gpsdata_pool_t *pool;
     /* make this a linked list using utlist.h or gps_utlist.h in
      * our case to make sure we get expected behavior */
     struct gpsdata_data *next;    
@@ -113,18 +160,530 @@ void gpsdata_list_free(gpsdata_data_t **listp);
 ssize_t gpsdata_list_count(const gpsdata_data_t *listp);
 void gpsdata_list_dump(const gpsdata_data_t *listp, FILE *fp);
 
+/* a list container that tracks the tail and the number of items so that
+ * appending items and concatenating lists takes constant time. The head is a
+ * regular gpsdata_data_t linked list and can be passed to the functions
+ * above, e.g. gpsdata_list_dump(list.head, fp).
+ */
+typedef struct {
+    gpsdata_data_t *head;
+    gpsdata_data_t *tail;
+    size_t count;
+} gpsdata_list_t;
+
+void gpsdata_list_init(gpsdata_list_t *);
+void gpsdata_list_append(gpsdata_list_t *, gpsdata_data_t *item);
+// moves all items in src to the end of dst and empties src
+void gpsdata_list_concat(gpsdata_list_t *dst, gpsdata_list_t *src);
+// frees all items in the list and re-initializes it
+void gpsdata_list_clear(gpsdata_list_t *);
+
+/* a pool of gpsdata_data_t items allocated in slabs of `capacity` items. The
+ * pool grows by another slab when it runs out of items. Items are handed back
+ * to the pool by gpsdata_list_free(). The pool is not thread-safe, so items
+ * must be freed on the same thread that parses with the pool.
+ * gpsdata_pool_free() can be called while items are still in use; the memory
+ * is then released when the last such item is returned.
+ */
+#define GPSDATA_POOL_DEFAULT_CAPACITY 16
+typedef struct {
+    uint64_t hits; // number of items served from the free list
+    uint64_t misses; // number of times the pool had to grow
+    size_t capacity; // total number of items owned by the pool
+    size_t available; // number of items on the free list
+} gpsdata_pool_stats_t;
+
+gpsdata_pool_t *gpsdata_pool_create(size_t capacity);
+void gpsdata_pool_free(gpsdata_pool_t *);
+// returns an initialized item or NULL on allocation failure
+gpsdata_data_t *gpsdata_pool_get(gpsdata_pool_t *);
+// returns an item to the pool it was drawn from
+void gpsdata_pool_put(gpsdata_data_t *);
+int gpsdata_pool_get_stats(const gpsdata_pool_t *, gpsdata_pool_stats_t *);
+
+/* a fixed-size copy of the fix of an item without any pointers, so that it
+ * can be handed to another thread or stored as is */
+typedef struct {
+    int64_t timestamp_usec; // microseconds since the epoch, 0 if not valid
+    int32_t latitude_e7; // GPSDATA_FIXED_UNSET if not available
+    int32_t longitude_e7;
+    int32_t altitude_mm;
+    int32_t speed_mmps;
+    float course_degrees; // NAN if not available
+    float hdop;
+    uint32_t fused_msgids;
+    uint8_t msgid; // gpsdata_msgid_t
+    uint8_t posfix; // gpsdata_posfix_t
+    uint8_t mode; // gpsdata_mode_t
+    uint8_t num_satellites;
+} gpsdata_fix_t;
+
+void gpsdata_fix_from_data(gpsdata_fix_t *, const gpsdata_data_t *);
+
+/* a lock-free ring of fixes between exactly one producer thread, e.g. the
+ * thread reading the device, and one consumer thread. Nothing is allocated
+ * after creation. If the ring is full the fixes that do not fit are dropped
+ * and counted as overruns, so the producer never waits for the consumer.
+ * With wakeup set the ring also has an eventfd that becomes readable when
+ * fixes are pushed, for use with poll()/epoll() in the consumer.
+ */
+typedef struct gpsdata_ring_t gpsdata_ring_t;
+// capacity is rounded up to a power of 2
+gpsdata_ring_t *gpsdata_ring_create(size_t capacity, bool wakeup);
+void gpsdata_ring_free(gpsdata_ring_t *);
+// producer only. returns the number of fixes pushed
+size_t gpsdata_ring_push(gpsdata_ring_t *, const gpsdata_fix_t *fixes, size_t count);
+// producer only. pushes the fix of every item in the list
+size_t gpsdata_ring_push_list(gpsdata_ring_t *, const gpsdata_data_t *listp);
+// consumer only. returns the number of fixes copied into fixes
+size_t gpsdata_ring_pop(gpsdata_ring_t *, gpsdata_fix_t *fixes, size_t max);
+uint64_t gpsdata_ring_overruns(const gpsdata_ring_t *);
+// the eventfd to poll for reading, or -1 if there is none
+int gpsdata_ring_fd(const gpsdata_ring_t *);
+
+/* the most recent value of each group of fields, with the time each group
+ * was last received as gpsutils_monotonic_ms(), or 0 if it never was */
+#define GPSDATA_LATEST_FW_LEN 32
+typedef struct {
+    uint64_t seq; // number of updates
+    uint64_t position_rx_ms;
+    int64_t timestamp_usec; // time of the position fix, 0 if not valid
+    int32_t latitude_e7;
+    int32_t longitude_e7;
+    uint8_t posfix; // gpsdata_posfix_t
+    uint8_t mode; // gpsdata_mode_t
+    uint8_t num_satellites;
+    uint64_t altitude_rx_ms;
+    int32_t altitude_mm;
+    uint64_t velocity_rx_ms;
+    int32_t speed_mmps;
+    float course_degrees;
+    uint64_t dop_rx_ms;
+    gpsdata_dop_t dop;
+    uint64_t antenna_rx_ms;
+    uint8_t antenna_status; // gpsdata_antenna_t
+    uint64_t firmware_rx_ms;
+    char firmware[GPSDATA_LATEST_FW_LEN]; // truncated copies of gpsdata_firmware_t
+    char build_id[GPSDATA_LATEST_FW_LEN];
+    char chip_name[GPSDATA_LATEST_FW_LEN];
+    char chip_version[GPSDATA_LATEST_FW_LEN];
+} gpsdata_latest_snapshot_t;
+
+/* the latest fix, updated by one writer thread and read by any number of
+ * threads. Readers never block the writer or each other; a read that
+ * overlaps an update retries.
+ */
+typedef struct gpsdata_latest_t gpsdata_latest_t;
+gpsdata_latest_t *gpsdata_latest_create(void);
+void gpsdata_latest_free(gpsdata_latest_t *);
+// writer only. merges the fields the item has into the latest fix
+void gpsdata_latest_update(gpsdata_latest_t *, const gpsdata_data_t *item);
+// return -1 on error and 0 on success
+int gpsdata_latest_read(const gpsdata_latest_t *, gpsdata_latest_snapshot_t *);
+
 typedef struct gpsdata_parser_t gpsdata_parser_t;
 
 gpsdata_parser_t *gpsdata_parser_create();
 void gpsdata_parser_free(gpsdata_parser_t *);
 void gpsdata_parser_reset(gpsdata_parser_t *);
 void gpsdata_parser_dump_state(const gpsdata_parser_t *, FILE *);
+/* every parser draws its message items from a pool of
+ * GPSDATA_POOL_DEFAULT_CAPACITY items by default. A capacity of 0 disables
+ * pooling and every item is allocated on the heap.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_pool_capacity(gpsdata_parser_t *, size_t capacity);
+int gpsdata_parser_get_pool_stats(const gpsdata_parser_t *, gpsdata_pool_stats_t *);
+/* by default a parse error fails the parse call and the parser has to be reset,
+ * which loses the rest of the buffer and the date of the last GPRMC message.
+ * With resync enabled the parser skips to the next '$' on error and carries
+ * on, and gpsdata_parser_parse() and gpsdata_parser_parse_list() return the
+ * number of errors they recovered from instead of -1.
+ * gpsdata_parser_parse_cb() and gpsdata_parser_parse_columns() return the
+ * number of messages delivered either way, so read the errors with
+ * gpsdata_parser_get_resync_stats() after calling them.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_resync(gpsdata_parser_t *, bool enable);
+// part of gpsdata_parser_get_stats(). either pointer may be NULL
+int gpsdata_parser_get_resync_stats(const gpsdata_parser_t *,
+            size_t *errors, size_t *dropped_bytes);
+/* deliver only the messages whose GPSDATA_MSGID_MASK() bit is set in mask.
+ * The rest are still checked and counted but no item is created for them.
+ * A GPRMC message is always parsed, since its date is needed for the
+ * timestamps of the messages that follow it, and so is a PMTK message while
+ * there is a gpsdata_parser_set_ack_cb() callback. The default is
+ * GPSDATA_MSGID_MASK_ALL.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_filter(gpsdata_parser_t *, uint32_t mask);
+/* the number of messages of each message ID dropped by the filter. part of
+ * gpsdata_parser_get_stats() */
+int gpsdata_parser_get_filter_drops(const gpsdata_parser_t *,
+            uint64_t drops[GPSDATA_MSGID_COUNT]);
+/* send the log messages of this parser to the sink instead of
+ * GPSUTILS_LOG_PTR. The sink must outlive the parser. NULL restores the default.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_logsink(gpsdata_parser_t *, const gpsutils_logsink_t *sink);
+/* update latest with every item the parser delivers. The parser becomes the
+ * writer of latest, which must outlive it. NULL stops the updates.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_latest(gpsdata_parser_t *, gpsdata_latest_t *latest);
+/* with fusion enabled the GPGGA, GPRMC, GPGLL, GPVTG and GPGSA messages that
+ * share one hhmmss.sss time are merged into a single item with the position,
+ * altitude, speed, course, fix, mode, satellites and DOPs of the epoch. The
+ * msgid of the item is that of the first message of the epoch and
+ * fused_msgids has the bits of all of them. GPVTG and GPGSA carry no time and
+ * join the open epoch. The epoch is delivered when a message of the next
+ * epoch arrives, or at the start of a parse call once timeout_ms have passed
+ * since the epoch began, or by gpsdata_parser_flush(). A timeout_ms of 0
+ * waits for the next epoch. Other messages are delivered as usual.
+ * Disabling fusion delivers the open epoch, which is handed out by the next
+ * parse call or by gpsdata_parser_flush().
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_fusion(gpsdata_parser_t *, bool enable, uint32_t timeout_ms);
+/* appends the open epoch to the list, if there is one, along with any items
+ * delivered since the last parse call, such as an epoch delivered by
+ * disabling fusion.
+ * returns the number of items appended or -1 on error
+ */
+int gpsdata_parser_flush(gpsdata_parser_t *, gpsdata_list_t *list);
+
+// bucket i > 0 of the latency histogram counts calls of [2^(i-1), 2^i) ns
+#define GPSDATA_PARSER_LATENCY_BUCKETS 32
+typedef struct {
+    uint64_t parse_calls;
+    uint64_t bytes; // bytes consumed by the parse calls
+    // messages with a good checksum, including those dropped by the filter
+    uint64_t sentences[GPSDATA_MSGID_COUNT];
+    uint64_t delivered[GPSDATA_MSGID_COUNT]; // items handed to the caller
+    uint64_t filter_drops[GPSDATA_MSGID_COUNT];
+    uint64_t checksum_errors;
+    uint64_t resync_errors; // errors the parser reset itself after
+    uint64_t resync_dropped; // bytes skipped while resynchronizing
+    uint64_t ignored; // messages parsed but not delivered, like GPGSV
+    uint64_t alloc_failures;
+    // only filled while the histogram is enabled. the last bucket has the rest
+    uint64_t latency_ns[GPSDATA_PARSER_LATENCY_BUCKETS];
+} gpsdata_parser_stats_t;
+/* the counters are plain integers updated by the parsing thread, so read them
+ * from that thread or synchronize with it. They count from the creation of
+ * the parser or the last gpsdata_parser_reset_stats(), which
+ * gpsdata_parser_reset() does not call.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_get_stats(const gpsdata_parser_t *, gpsdata_parser_stats_t *);
+int gpsdata_parser_reset_stats(gpsdata_parser_t *);
+/* time every parse call on CLOCK_MONOTONIC into latency_ns. Off by default.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_latency_histogram(gpsdata_parser_t *, bool enable);
+
+/* the host time the next buffer was read, in microseconds on any clock such
+ * as CLOCK_MONOTONIC or CLOCK_REALTIME. It is taken as the arrival of the last
+ * byte of the buffer and the arrival of the '$' of each message in it is
+ * interpolated back from it at the baud rate. It applies to the next parse
+ * call only, and messages of buffers without a time get an rx_usec of 0.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_rx_time(gpsdata_parser_t *, int64_t rx_usec);
+/* the baud rate of the link, with 10 bits per byte. 0, the default, gives
+ * every message the time of its buffer.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_set_baudrate(gpsdata_parser_t *, uint32_t baudrate);
+typedef struct {
+    uint64_t count;
+    int64_t last_usec;
+    int64_t min_usec;
+    int64_t max_usec;
+    double mean_usec;
+    double stddev_usec;
+    // smoothed difference of consecutive offsets like the RFC 3550 jitter
+    double jitter_usec;
+} gpsdata_rx_offset_stats_t;
+/* the offset is rx_usec minus the GPS time of every delivered item that has
+ * both. With CLOCK_REALTIME it is the latency from the receiver to the host
+ * plus the error of the host clock. On any clock the spread and the jitter
+ * show how steady the link is. gpsdata_parser_reset_stats() clears these too.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_get_rx_offset_stats(const gpsdata_parser_t *,
+            gpsdata_rx_offset_stats_t *);
+
+/* PMTK001 acknowledgements carry the command ID and a flag of 0 for an
+ * invalid command, 1 for an unsupported one, 2 for a failed action and 3 for
+ * success. They are not delivered as items; with a callback set each one is
+ * handed to it from within the parse call instead, even if the filter of
+ * gpsdata_parser_set_filter() leaves out PMTK. Pass NULL to remove it.
+ * return -1 on error and 0 on success
+ */
+typedef void (*gpsdata_parser_ack_cb_t)(uint16_t cmd, uint8_t flag, void *userdata);
+int gpsdata_parser_set_ack_cb(gpsdata_parser_t *, gpsdata_parser_ack_cb_t,
+            void *userdata);
+
+// bits of gpsdata_skyview_sat_t.null_mask for fields that were empty
+#define GPSDATA_SKYVIEW_NULL_ELEVATION 0x01
+#define GPSDATA_SKYVIEW_NULL_AZIMUTH 0x02
+#define GPSDATA_SKYVIEW_NULL_SNR 0x04
+typedef struct {
+    uint8_t satellite_id; // 0 if empty
+    uint8_t elevation; // degrees, 0-90
+    uint16_t azimuth; // degrees, 0-359
+    uint8_t snr_cno; // dB-Hz, 0-99
+    uint8_t null_mask;
+} gpsdata_skyview_sat_t;
+
+// a GPGSV group has at most 9 messages of 4 satellites each
+#define GPSDATA_SKYVIEW_SATS_MAX 36
+typedef struct {
+    uint64_t seq; // incremented for every complete group, 0 if there is none yet
+    uint64_t groups_dropped; // incomplete groups and out of order messages
+    uint8_t num_in_view; // as reported by the receiver
+    uint8_t num_sats; // entries filled in sats
+    gpsdata_skyview_sat_t sats[GPSDATA_SKYVIEW_SATS_MAX];
+} gpsdata_skyview_t;
+/* the GPGSV messages of a group (1 of N to N of N) are assembled into a table
+ * owned by the parser, which becomes the sky view once the last message of
+ * the group arrives. GPGSV messages are not delivered as items. A group is
+ * dropped if a message is missing or out of order. Filtering out GPGSV
+ * messages stops the updates. This copies the last complete sky view; check
+ * seq to see if it has changed.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_parser_get_skyview(const gpsdata_parser_t *, gpsdata_skyview_t *);
 
 int gpsdata_parser_parse(gpsdata_parser_t *ptr,
             const char *buf, size_t buflen,
             gpsdata_data_t **listp, // the link list pointer to which to append the results to
             size_t *outnum // the number of elements added to the list in this call
             );
+/* same as gpsdata_parser_parse() but appends to a gpsdata_list_t in constant
+ * time irrespective of how many items the list already holds. outnum is
+ * optional and is always set.
+ */
+int gpsdata_parser_parse_list(gpsdata_parser_t *ptr,
+            const char *buf, size_t buflen,
+            gpsdata_list_t *list, size_t *outnum);
+
+/* the callback receives a message item that lives in storage owned by the
+ * parser. It is valid only for the duration of the callback, so the callback
+ * must copy whatever it needs. The item is never added to a list and must not
+ * be freed.
+ */
+typedef void (*gpsdata_parser_cb_t)(const gpsdata_data_t *item, void *userdata);
+/* parses the buffer and invokes the callback for each message as soon as its
+ * checksum has been parsed. No memory is allocated per message.
+ * returns the number of messages delivered to the callback or -1 on error.
+ * With resync enabled the errors recovered from are only counted in
+ * gpsdata_parser_get_resync_stats().
+ */
+int gpsdata_parser_parse_cb(gpsdata_parser_t *ptr,
+            const char *buf, size_t buflen,
+            gpsdata_parser_cb_t cb, void *userdata);
+
+/* caller-provided column arrays for bulk decoding. One row is written per
+ * message at index `count` of every column that is not NULL. The caller owns
+ * the arrays and each must hold at least `capacity` elements. Unavailable
+ * values are NAN for floating point columns and 0 for timestamps.
+ */
+typedef struct {
+    size_t capacity;
+    size_t count; // rows filled so far. reset to 0 after draining the columns
+    int64_t *timestamp_usec; // microseconds since the epoch, if valid
+    double *latitude; // signed degrees
+    double *longitude; // signed degrees
+    float *altitude_meters;
+    float *speed_knots;
+    float *course_degrees;
+    uint8_t *msgid; // gpsdata_msgid_t
+    uint8_t *posfix; // gpsdata_posfix_t
+    uint8_t *num_satellites;
+} gpsdata_columns_t;
+
+/* decodes the buffer into the columns until they are full. consumed is set
+ * to the number of bytes of the buffer that were parsed, so the caller can
+ * drain the columns and resume with buf + consumed. The parser state carries
+ * over, so resuming in the middle of a message is fine.
+ * returns the number of rows added or -1 on error. With resync enabled the
+ * errors recovered from are only counted in gpsdata_parser_get_resync_stats().
+ */
+int gpsdata_parser_parse_columns(gpsdata_parser_t *ptr,
+            const char *buf, size_t buflen,
+            gpsdata_columns_t *cols, size_t *consumed);
+
+/* decodes a whole buffer of NMEA messages using nthreads threads, or as many
+ * threads as there are online CPUs if nthreads is 0. The buffer is split into
+ * chunks at message boundaries and each chunk is parsed by its own parser.
+ * The results are appended to the list in buffer order and are identical to
+ * those of a single parser, including GPGGA/GPGLL timestamps that depend on
+ * the date of an earlier GPRMC message. The parsers resynchronize, see
+ * gpsdata_parser_set_resync(), so a corrupt or truncated message is skipped
+ * instead of failing the call. outnum is optional.
+ * return -1 on error or the number of errors recovered from across all chunks
+ */
+int gpsdata_parse_buffer_parallel(const char *buf, size_t buflen, size_t nthreads,
+            gpsdata_list_t *list, size_t *outnum);
+/* same as above but memory maps the file at path and decodes it */
+int gpsdata_parse_file_parallel(const char *path, size_t nthreads,
+            gpsdata_list_t *list, size_t *outnum);
+
+/* a binary log of fixes. The file is a 32 byte header followed by 32 byte
+ * records, all little-endian, so a reader can map the file and use the
+ * records as an array without parsing them.
+ */
+#define GPSDATA_BINLOG_MAGIC "GPSBLOG"
+#define GPSDATA_BINLOG_VERSION 1
+typedef struct {
+    char magic[8]; // GPSDATA_BINLOG_MAGIC
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t reserved;
+    int64_t created_usec; // wall clock time the file was created
+    uint64_t reserved2;
+} gpsdata_binlog_header_t;
+
+// bits of gpsdata_binlog_record_t.flags for the fields that are set
+#define GPSDATA_BINLOG_HAS_TIME 0x0001
+#define GPSDATA_BINLOG_HAS_POSITION 0x0002
+#define GPSDATA_BINLOG_HAS_ALTITUDE 0x0004
+#define GPSDATA_BINLOG_HAS_SPEED 0x0008
+#define GPSDATA_BINLOG_HAS_COURSE 0x0010
+#define GPSDATA_BINLOG_HAS_HDOP 0x0020
+#define GPSDATA_BINLOG_FUSED 0x0040
+typedef struct {
+    int64_t timestamp_usec;
+    int32_t latitude_e7;
+    int32_t longitude_e7;
+    int32_t altitude_mm;
+    uint16_t speed_cmps; // cm/s, saturates at 655.35 m/s
+    uint16_t course_cdeg; // 0.01 degrees
+    uint16_t hdop_centi; // 0.01
+    uint16_t flags;
+    uint8_t msgid; // gpsdata_msgid_t
+    uint8_t posfix; // gpsdata_posfix_t
+    uint8_t mode; // gpsdata_mode_t
+    uint8_t num_satellites;
+} gpsdata_binlog_record_t;
+
+void gpsdata_binlog_record_from_fix(gpsdata_binlog_record_t *, const gpsdata_fix_t *);
+void gpsdata_binlog_record_to_fix(const gpsdata_binlog_record_t *, gpsdata_fix_t *);
+
+/* appends records to the file at path in batches of batch_records, or
+ * GPSDATA_BINLOG_DEFAULT_BATCH if 0. The file is created if needed. A
+ * partial record at the end of an existing file is cut off.
+ */
+#define GPSDATA_BINLOG_DEFAULT_BATCH 128
+typedef struct gpsdata_binlog_writer_t gpsdata_binlog_writer_t;
+gpsdata_binlog_writer_t *gpsdata_binlog_writer_open(const char *path,
+            size_t batch_records);
+/* the fix is added to the batch, which is written out when full. A batch
+ * that fails to write is kept and retried by the next append or flush.
+ * return -1 if the fix could not be added and 0 on success
+ */
+int gpsdata_binlog_writer_append(gpsdata_binlog_writer_t *, const gpsdata_fix_t *);
+// appends the fix of every item in the list. return -1 on error and 0 on success
+int gpsdata_binlog_writer_append_list(gpsdata_binlog_writer_t *,
+            const gpsdata_data_t *listp);
+/* writes out the batch. A failed write is cut back off the file so that it
+ * ends on a record, and the batch is kept. If that fails too, the writer
+ * refuses further writes.
+ * return -1 on error and 0 on success
+ */
+int gpsdata_binlog_writer_flush(gpsdata_binlog_writer_t *);
+// flushes and closes. return -1 if the flush failed and 0 on success
+int gpsdata_binlog_writer_close(gpsdata_binlog_writer_t *);
+
+/* maps the file at path read-only. The records stay valid until the reader
+ * is closed. A partial record at the end of the file is ignored.
+ */
+typedef struct gpsdata_binlog_reader_t gpsdata_binlog_reader_t;
+gpsdata_binlog_reader_t *gpsdata_binlog_reader_open(const char *path);
+const gpsdata_binlog_record_t *gpsdata_binlog_reader_records(
+            const gpsdata_binlog_reader_t *, size_t *count);
+void gpsdata_binlog_reader_close(gpsdata_binlog_reader_t *);
+
+/* a streaming codec for fixes. Each record is a varint bitmap of the fields
+ * that differ from their prediction, followed by the zigzag varint
+ * difference of each of those fields. Fields are predicted to be unchanged,
+ * and the timestamp to advance by the same step as before. Every
+ * restart_interval records the state is reset, so a decoder can start at any
+ * such record; keep the offsets of the records flagged as restarts to seek.
+ * The state is fixed in size and nothing is allocated.
+ */
+#define GPSDATA_CODEC_CHANNELS 12
+// the largest encoded record
+#define GPSDATA_CODEC_MAX_RECORD 128
+#define GPSDATA_CODEC_DEFAULT_RESTART 256
+typedef struct {
+    int64_t prev[GPSDATA_CODEC_CHANNELS];
+    int64_t prev_step; // the last timestamp difference
+    uint32_t restart_interval;
+    uint32_t count; // records since the last restart
+} gpsdata_codec_t;
+
+// a restart_interval of 0 uses GPSDATA_CODEC_DEFAULT_RESTART
+void gpsdata_codec_init(gpsdata_codec_t *, uint32_t restart_interval);
+/* returns the number of bytes written to out or -1 if outlen is too small.
+ * restart is optional and is set if the record starts a restart point
+ */
+int gpsdata_codec_encode(gpsdata_codec_t *, const gpsdata_fix_t *fix,
+            uint8_t *out, size_t outlen, bool *restart);
+/* returns the number of bytes consumed, 0 if the record is incomplete and
+ * -1 if it is corrupt. The decoder must be initialized with the same
+ * restart_interval as the encoder.
+ */
+int gpsdata_codec_decode(gpsdata_codec_t *, const uint8_t *in, size_t inlen,
+            gpsdata_fix_t *fix);
+
+/* a generator of synthetic MTK3339 style NMEA streams for load testing. It
+ * follows a trajectory that wanders from the start position and emits the
+ * sentences of msgid_mask for every fix, GPGSV groups and PGTOP/PMTK
+ * responses at the given intervals, all with correct checksums unless errors
+ * are injected. The same seed always gives the same stream.
+ */
+typedef struct {
+    uint64_t seed;
+    uint32_t fix_interval_ms; // 1000 for the default 1Hz
+    // GPSDATA_MSGID_MASK() bits of GPGGA, GPRMC, GPGLL, GPVTG and GPGSA
+    uint32_t msgid_mask;
+    uint32_t gsv_every; // a GPGSV group every N fixes. 0 disables them
+    uint32_t pgtop_every; // a PGTOP antenna status every N fixes. 0 disables
+    uint32_t pmtk_every; // a PMTK705 firmware response every N fixes. 0 disables
+    double start_latitude; // signed degrees
+    double start_longitude; // signed degrees
+    float altitude_meters;
+    float speed_mps; // the mean speed, 0 stays in place
+    int64_t start_usec; // the time of the first fix, microseconds since the epoch
+    // probability per sentence of each kind of error, 0 to 1
+    double bitflip_rate; // one bit of the sentence is flipped
+    double truncate_rate; // the sentence is cut short
+    double bad_checksum_rate; // the checksum digits are wrong
+} gpsdata_generator_config_t;
+
+typedef struct {
+    uint64_t fixes;
+    uint64_t sentences;
+    uint64_t bytes;
+    uint64_t bitflips;
+    uint64_t truncations;
+    uint64_t bad_checksums;
+} gpsdata_generator_stats_t;
+
+typedef struct gpsdata_generator_t gpsdata_generator_t;
+// fills the config with a 1Hz stream of all sentences and no errors
+void gpsdata_generator_config_default(gpsdata_generator_config_t *);
+gpsdata_generator_t *gpsdata_generator_create(const gpsdata_generator_config_t *);
+void gpsdata_generator_free(gpsdata_generator_t *);
+/* fills the whole buffer with the stream. Sentences continue across calls.
+ * returns the number of bytes written or -1 on error
+ */
+ssize_t gpsdata_generator_fill(gpsdata_generator_t *, char *buf, size_t buflen);
+int gpsdata_generator_get_stats(const gpsdata_generator_t *,
+            gpsdata_generator_stats_t *);
 
 /* this is necessary if you're reading the chip using this library.
  * you can call open() on the device and get a filedescriptor and then call this
@@ -134,6 +693,19 @@ int gpsdata_parser_parse(gpsdata_parser_t *ptr,
  * is used. -1 is returned if fd is invalid or setting the baud rate has failed
  */
 int gpsdevice_set_baudrate(int fd, uint32_t baud_rate);
+#define GPSDEVICE_NEGOTIATE_TIMEOUT_MS 2000
+/* changes the baud rate of a chip that is sending at current_baud. The
+ * PMTK251 command is sent at current_baud before the local speed is changed,
+ * and the link is verified by waiting up to timeout_ms for a message with a
+ * good checksum at the new rate. If none arrives the chip is asked to go back
+ * and the link is verified at current_baud again. Pick a timeout_ms of at
+ * least twice the fix interval; 0 uses GPSDEVICE_NEGOTIATE_TIMEOUT_MS. The fd
+ * must not be read elsewhere meanwhile.
+ * returns the baud rate in effect, baud_rate or current_baud, or -1 if the
+ * link is lost or the rates are not supported
+ */
+int gpsdevice_negotiate_baudrate(int fd, uint32_t current_baud,
+            uint32_t baud_rate, uint32_t timeout_ms);
 /* a wrapper function for opening device in Read-only mode and setting baud rate
  * to 9600 bps. this function calls gpsutils_set_baudrate() with 9600 bps
  * internally. sets the fix interval to 1000 milliseconds. sets the enabled
@@ -164,7 +736,8 @@ int gpsdevice_set_standby(int fd);
 /* the position fix interval is set here. values can range between 100 and
  * 10000 milliseconds. any value > 10000 is 10000, and any value < 100 is 100.
  * return -1 on error and 0 on success
- * for a 9600 Baud rate your value should be at least 1000
+ * the baud rate must keep up with the enabled sentences, see
+ * gpsdevice_min_fix_interval() for the shortest interval that it allows
  */
 int gpsdevice_set_fix_interval(int fd, uint16_t milliseconds);
 
@@ -173,6 +746,19 @@ int gpsdevice_set_fix_interval(int fd, uint16_t milliseconds);
 // if GPVTG/GPGSA are enabled the frequency is set to every 1 position fix
 // if GPGSV is enabled the frequency is set to every 5 position fixes.
 int gpsdevice_set_enabled(int fd, bool is_gpvtg, bool is_gpgsa, bool is_gpgsv);
+/* the shortest fix interval, in multiples of 100 milliseconds, at which the
+ * sentences of gpsdevice_set_enabled() use at most 80% of baud_rate.
+ * returns 0 if the baud rate is not supported
+ */
+uint16_t gpsdevice_min_fix_interval(uint32_t baud_rate, bool is_gpvtg,
+            bool is_gpgsa, bool is_gpgsv);
+/* enables the sentences and then sets the fix interval, raised to
+ * gpsdevice_min_fix_interval() if the link is too slow for milliseconds. Use
+ * it after gpsdevice_negotiate_baudrate() to go to 5-10 Hz.
+ * returns the fix interval set or -1 on error
+ */
+int gpsdevice_set_fix_interval_safe(int fd, uint32_t baud_rate,
+            uint16_t milliseconds, bool is_gpvtg, bool is_gpgsa, bool is_gpgsv);
 
 /* navspeed threshold in m/s. valid values are 0, 0.2, 0.4, 0.6, 0.8, 1.0, 1.5,
  * 2.0 m/s. Any other value defaults to 0.2 m/s. 0 m/s disables the speed
@@ -203,9 +789,102 @@ int gpsdevice_request_antenna_status(int fd, bool once, bool periodic_enable);
 /* send a custom PMTK message that is not supported by the above API calls.
  * user must read datasheet before using this directly. all the above API calls
  * use this function internally. The msg pointer is expected to be a NULL
- * terminated string.
+ * terminated string. The whole message is written, and on a non-blocking fd
+ * this waits up to GPSDEVICE_SEND_TIMEOUT_MS at a time for the fd to become
+ * writable. Use gpsdevice_writer_t to never block instead.
+ * return -1 on error and 0 on success
  */
+#define GPSDEVICE_SEND_TIMEOUT_MS 1000
 int gpsdevice_send_message(int fd, const char *msg);
 
+/* buffered non-blocking output to a device. Messages are queued whole, or not
+ * at all if the buffer cannot hold them, so a message is never cut. A flush
+ * writes everything queued in as few write() calls as the fd accepts and
+ * keeps the rest when the fd returns EAGAIN or takes a part of it, to be
+ * resumed by the next flush. The hook tells an event loop when to watch the
+ * fd for writability: it is called with want_writable true when the queue
+ * stops being empty and with false once a flush has emptied it. Flushing
+ * from the writable callback then coalesces all that was queued in the
+ * meantime into one write. The writer does not own or close the fd and is
+ * not thread-safe.
+ */
+#define GPSDEVICE_WRITER_DEFAULT_CAPACITY 1024
+typedef struct gpsdevice_writer_t gpsdevice_writer_t;
+typedef void (*gpsdevice_writer_hook_t)(int fd, bool want_writable, void *userdata);
+/* a capacity of 0 picks the default */
+gpsdevice_writer_t *gpsdevice_writer_create(int fd, size_t capacity);
+void gpsdevice_writer_free(gpsdevice_writer_t *);
+int gpsdevice_writer_set_hook(gpsdevice_writer_t *, gpsdevice_writer_hook_t,
+                void *userdata);
+/* queue a NULL terminated message such as "$PMTK220,200*2C\r\n".
+ * return -1 on error or if it does not fit and 0 on success
+ */
+int gpsdevice_writer_queue(gpsdevice_writer_t *, const char *msg);
+/* return -1 on error or the number of bytes still queued. A write error
+ * other than EAGAIN or EINTR drops everything queued and calls the hook with
+ * false, so the next queued message starts afresh and re-arms the hook.
+ */
+ssize_t gpsdevice_writer_flush(gpsdevice_writer_t *);
+size_t gpsdevice_writer_pending(const gpsdevice_writer_t *);
+
+/* asynchronous PMTK commands. A command is written as soon as it is submitted
+ * and completes when its PMTK001 acknowledgement comes back through the parser,
+ * so that configuring the device does not wait a round trip per command.
+ * Commands with different IDs are pipelined, up to max_inflight at a time, and
+ * a command waits for an earlier one with the same ID since the acks cannot be
+ * told apart. A command without an ack within timeout_ms is resent up to
+ * retries times before it times out. The callback gets the PMTK001 flag as
+ * the status, or TIMEDOUT, or CANCELLED if the queue is freed first.
+ * Commands that are not acknowledged by PMTK001, such as PMTK605, do not
+ * belong on the queue. The queue is not thread-safe, and callbacks must not
+ * free it.
+ */
+typedef enum {
+    GPSDEVICE_CMD_INVALID = 0,
+    GPSDEVICE_CMD_UNSUPPORTED = 1,
+    GPSDEVICE_CMD_FAILED = 2,
+    GPSDEVICE_CMD_SUCCESS = 3,
+    GPSDEVICE_CMD_TIMEDOUT,
+    GPSDEVICE_CMD_CANCELLED
+} gpsdevice_cmd_status_t;
+const char *gpsdevice_cmd_status_tostring(gpsdevice_cmd_status_t);
+
+#define GPSDEVICE_CMDQ_DEFAULT_TIMEOUT_MS 1000
+#define GPSDEVICE_CMDQ_DEFAULT_RETRIES 2
+#define GPSDEVICE_CMDQ_DEFAULT_INFLIGHT 4
+typedef void (*gpsdevice_cmd_cb_t)(uint16_t cmd, gpsdevice_cmd_status_t status,
+                                   void *userdata);
+typedef struct gpsdevice_cmdq_t gpsdevice_cmdq_t;
+/* a timeout_ms or max_inflight of 0 picks the default */
+gpsdevice_cmdq_t *gpsdevice_cmdq_create(int fd, uint32_t timeout_ms,
+                uint8_t retries, size_t max_inflight);
+void gpsdevice_cmdq_free(gpsdevice_cmdq_t *);
+/* queue the commands on the writer instead of writing them to the fd.
+ * Pass NULL to write to the fd again.
+ * return -1 on error and 0 on success
+ */
+int gpsdevice_cmdq_set_writer(gpsdevice_cmdq_t *, gpsdevice_writer_t *);
+/* msg is the command without the '$' and the checksum, such as "PMTK220,200".
+ * the callback may be NULL.
+ * return -1 on error and 0 on success
+ */
+int gpsdevice_cmdq_submit(gpsdevice_cmdq_t *, const char *msg,
+                gpsdevice_cmd_cb_t cb, void *userdata);
+/* complete the oldest command in flight with the ID cmd and send what was
+ * waiting on it.
+ * return -1 if no such command is in flight and 0 on success
+ */
+int gpsdevice_cmdq_ack(gpsdevice_cmdq_t *, uint16_t cmd, uint8_t flag);
+/* gpsdevice_cmdq_ack() as a gpsdata_parser_ack_cb_t with the queue as the
+ * userdata of gpsdata_parser_set_ack_cb()
+ */
+void gpsdevice_cmdq_parser_ack(uint16_t cmd, uint8_t flag, void *cmdq);
+/* resend or time out commands that have waited too long and send those that
+ * can go. Call it periodically, say from the timer of the event loop.
+ * return -1 on error or the number of commands not yet completed
+ */
+int gpsdevice_cmdq_poll(gpsdevice_cmdq_t *);
+size_t gpsdevice_cmdq_pending(const gpsdevice_cmdq_t *);
+
 EXTERN_C_END
 #endif /* __GPSDATA_H__ */
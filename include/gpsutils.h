@@ -85,23 +85,42 @@ extern volatile int gpsutils_loglevel; /* defined in utils.c */
 #define GPSUTILS_LOGLEVEL_STRINGIFY(A) GPSUTILS_STRINGIFY2(GPSUTILS_LOGLEVEL_,A)
 #define GPSUTILS_LOGLEVEL_SET(A) gpsutils_loglevel = GPSUTILS_LOGLEVEL_STRINGIFY(A)
 #define GPSUTILS_LOGLEVEL_IS(A) (gpsutils_loglevel >= GPSUTILS_LOGLEVEL_STRINGIFY(A))
+// the most verbose log level compiled in, set with ./configure --with-log-level.
+// log calls above it are removed at compile time
+#ifdef LIBGPS_MTK3339_LOGLEVEL_COMPILED
+    #define GPSUTILS_LOGLEVEL_COMPILED LIBGPS_MTK3339_LOGLEVEL_COMPILED
+#else
+    #define GPSUTILS_LOGLEVEL_COMPILED GPSUTILS_LOGLEVEL_DEBUG
+#endif
+#define GPSUTILS_LOGLEVEL_IS_COMPILED(A) \
+    (GPSUTILS_LOGLEVEL_STRINGIFY(A) <= GPSUTILS_LOGLEVEL_COMPILED)
+
+/* a log sink receives each formatted log line, including its level prefix.
+ * fmt is the format string of the log call and identifies the call site.
+ * the message is not NUL terminated and is only valid during the call.
+ */
+typedef struct {
+    void (*write)(void *ctx, int level, const char *fmt, const char *msg, size_t len);
+    void *ctx;
+} gpsutils_logsink_t;
+
+// define GPSUTILS_LOG_SINK to a gpsutils_logsink_t pointer expression to
+// redirect the log calls of a source file. NULL writes to GPSUTILS_LOG_PTR
+#ifndef GPSUTILS_LOG_SINK
+#define GPSUTILS_LOG_SINK NULL
+#endif
 #ifdef NDEBUG
-    #define GPSUTILS_LOG_THIS(A,...) \
-    do { \
-        if (GPSUTILS_LOGLEVEL_IS(A)) { \
-            fprintf(GPSUTILS_LOG_PTR, "%s: ", GPSUTILS_STRINGIFY(A)); \
-            fprintf(GPSUTILS_LOG_PTR, __VA_ARGS__); \
-        } \
-    } while (0)
-#else  /* NDEBUG not defined */
-    #define GPSUTILS_LOG_THIS(A,...) \
+    #define GPSUTILS_LOG_SITE NULL, 0
+#else
+    #define GPSUTILS_LOG_SITE __func__, __LINE__
+#endif
+#define GPSUTILS_LOG_THIS(A,...) \
     do { \
-        if (GPSUTILS_LOGLEVEL_IS(A)) { \
-            fprintf(GPSUTILS_LOG_PTR, "%s: [%s:%d] ", GPSUTILS_STRINGIFY(A), __func__, __LINE__); \
-            fprintf(GPSUTILS_LOG_PTR, __VA_ARGS__); \
+        if (GPSUTILS_LOGLEVEL_IS_COMPILED(A) && GPSUTILS_LOGLEVEL_IS(A)) { \
+            gpsutils_log_printf(GPSUTILS_LOG_SINK, GPSUTILS_LOG_PTR, \
+                GPSUTILS_LOGLEVEL_STRINGIFY(A), GPSUTILS_LOG_SITE, __VA_ARGS__); \
         } \
     } while (0)
-#endif
 #define GPSUTILS_DEBUG(...) GPSUTILS_LOG_THIS(DEBUG,__VA_ARGS__)
 #define GPSUTILS_INFO(...) GPSUTILS_LOG_THIS(INFO, __VA_ARGS__)
 #define GPSUTILS_ERROR(...) GPSUTILS_LOG_THIS(ERROR, __VA_ARGS__)
@@ -119,6 +138,36 @@ extern volatile int gpsutils_loglevel; /* defined in utils.c */
     } while (0)
 #endif
 
+#ifdef __GNUC__
+__attribute__((format(printf, 6, 7)))
+#endif
+void gpsutils_log_printf(const gpsutils_logsink_t *sink, FILE *fp, int level,
+            const char *func, int line, const char *fmt, ...);
+
+/* a sink that copies messages into a lock-free ring buffer which a background
+ * thread drains into fp. Any number of threads can log to it and they never
+ * block. Messages are dropped if the ring is full and long messages are
+ * truncated.
+ */
+typedef struct gpsutils_logring_t gpsutils_logring_t;
+// capacity is rounded up to a power of 2. returns NULL on error
+gpsutils_logring_t *gpsutils_logring_create(size_t capacity, FILE *fp);
+// stops the thread after writing out the messages in the ring
+void gpsutils_logring_free(gpsutils_logring_t *);
+const gpsutils_logsink_t *gpsutils_logring_sink(gpsutils_logring_t *);
+uint64_t gpsutils_logring_dropped(const gpsutils_logring_t *);
+
+/* a sink that forwards at most burst messages from each call site per
+ * interval_ms milliseconds to next, or to GPSUTILS_LOG_PTR if next is NULL,
+ * and then reports how many were suppressed. It is not thread-safe, so use one
+ * per parser.
+ */
+typedef struct gpsutils_lograte_t gpsutils_lograte_t;
+gpsutils_lograte_t *gpsutils_lograte_create(const gpsutils_logsink_t *next,
+            uint32_t burst, uint32_t interval_ms);
+void gpsutils_lograte_free(gpsutils_lograte_t *);
+const gpsutils_logsink_t *gpsutils_lograte_sink(gpsutils_lograte_t *);
+
 typedef struct {
     double start;
     double stop;
@@ -127,7 +176,20 @@ typedef struct {
 
 void gpsutils_timer_start(gpsutils_timer_t *tt);
 void gpsutils_timer_stop(gpsutils_timer_t *tt);
+// milliseconds on CLOCK_MONOTONIC, for measuring intervals
+uint64_t gpsutils_monotonic_ms(void);
+// nanoseconds on CLOCK_MONOTONIC
+uint64_t gpsutils_monotonic_ns(void);
+/* converts a UTC broken-down time to a timeval like timegm() does, but with
+ * integer arithmetic only, so it is thread-safe and does not depend on TZ */
 int gpsutils_get_timeval(const struct tm *tm1, uint32_t millisecs, struct timeval *tv);
+// seconds since the epoch at UTC midnight of the date of tm1
+int64_t gpsutils_get_day_epoch(const struct tm *tm1);
+/* same as gpsutils_get_timeval() for a day epoch from gpsutils_get_day_epoch().
+ * only the time of day fields of tm1 are used, so the day epoch can be cached
+ */
+int gpsutils_get_timeval_day(int64_t day_epoch, const struct tm *tm1,
+            uint32_t millisecs, struct timeval *tv);
 void gpsutils_hex_dump(const uint8_t *in, size_t inlen, FILE *fp);
 uint8_t gpsutils_hex_parse(const char a);
 void gpsutils_string_toupper(char *s);
@@ -137,6 +199,23 @@ void gpsutils_string_toupper(char *s);
  * calculate its length
  */
 int gpsutils_checksum(const char *buf, ssize_t len);
+/* XOR of all bytes in buf, which is the NMEA checksum of the bytes between
+ * '$' and '*'. uses SSE2/AVX2 or NEON when the compiler targets them.
+ */
+uint8_t gpsutils_xor_bytes(const char *buf, size_t len);
+
+/* the longest message we look ahead for. NMEA limits messages to 82
+ * characters but the PMTK firmware response can be longer.
+ */
+#define GPSUTILS_NMEA_MAX_LENGTH 256
+/*
+ * verify the checksum of the message that starts with '$' at msg, looking at
+ * most len bytes ahead. returns 1 if the checksum matches, 0 if it does not and
+ * -1 if the message is incomplete or its checksum digits are not hexadecimal.
+ * msglen, if not NULL, is set to the length of the message up to and including
+ * the checksum digits when 0 or 1 is returned.
+ */
+int gpsutils_checksum_verify(const char *msg, size_t len, size_t *msglen);
 
 EXTERN_C_END
 
@@ -0,0 +1,425 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+#ifdef LIBGPS_MTK3339_HAVE_ERRNO_H
+    #include <errno.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_FCNTL_H
+    #include <fcntl.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_SYS_STAT_H
+    #include <sys/stat.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_SYS_MMAN_H
+    #include <sys/mman.h>
+#endif
+
+_Static_assert(sizeof(gpsdata_binlog_header_t) == 32, "binlog header must be 32 bytes");
+_Static_assert(sizeof(gpsdata_binlog_record_t) == 32, "binlog record must be 32 bytes");
+
+/** NOTE: the file is little-endian. On big-endian hosts the writer swaps each
+ * record before writing it and the reader keeps a swapped copy of the file
+ * instead of using the mapping directly **/
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    #define GPSDATA_BINLOG_SWAP 1
+#endif
+
+static void gpsdata_binlog_swap_record(gpsdata_binlog_record_t *rec)
+{
+#ifdef GPSDATA_BINLOG_SWAP
+    rec->timestamp_usec = (int64_t)__builtin_bswap64((uint64_t)rec->timestamp_usec);
+    rec->latitude_e7 = (int32_t)__builtin_bswap32((uint32_t)rec->latitude_e7);
+    rec->longitude_e7 = (int32_t)__builtin_bswap32((uint32_t)rec->longitude_e7);
+    rec->altitude_mm = (int32_t)__builtin_bswap32((uint32_t)rec->altitude_mm);
+    rec->speed_cmps = __builtin_bswap16(rec->speed_cmps);
+    rec->course_cdeg = __builtin_bswap16(rec->course_cdeg);
+    rec->hdop_centi = __builtin_bswap16(rec->hdop_centi);
+    rec->flags = __builtin_bswap16(rec->flags);
+#else
+    (void)rec;
+#endif
+}
+
+static void gpsdata_binlog_swap_header(gpsdata_binlog_header_t *hdr)
+{
+#ifdef GPSDATA_BINLOG_SWAP
+    hdr->version = __builtin_bswap16(hdr->version);
+    hdr->record_size = __builtin_bswap16(hdr->record_size);
+    hdr->reserved = __builtin_bswap32(hdr->reserved);
+    hdr->created_usec = (int64_t)__builtin_bswap64((uint64_t)hdr->created_usec);
+    hdr->reserved2 = __builtin_bswap64(hdr->reserved2);
+#else
+    (void)hdr;
+#endif
+}
+
+static uint16_t gpsdata_binlog_u16(double v)
+{
+    if (v <= 0)
+        return 0;
+    return (v >= UINT16_MAX) ? UINT16_MAX : (uint16_t)(v + 0.5);
+}
+
+void gpsdata_binlog_record_from_fix(gpsdata_binlog_record_t *rec, const gpsdata_fix_t *fix)
+{
+    if (!rec || !fix)
+        return;
+    memset(rec, 0, sizeof(*rec));
+    if (fix->timestamp_usec != 0) {
+        rec->timestamp_usec = fix->timestamp_usec;
+        rec->flags |= GPSDATA_BINLOG_HAS_TIME;
+    }
+    if (fix->latitude_e7 != GPSDATA_FIXED_UNSET &&
+        fix->longitude_e7 != GPSDATA_FIXED_UNSET) {
+        rec->latitude_e7 = fix->latitude_e7;
+        rec->longitude_e7 = fix->longitude_e7;
+        rec->flags |= GPSDATA_BINLOG_HAS_POSITION;
+    }
+    if (fix->altitude_mm != GPSDATA_FIXED_UNSET) {
+        rec->altitude_mm = fix->altitude_mm;
+        rec->flags |= GPSDATA_BINLOG_HAS_ALTITUDE;
+    }
+    if (fix->speed_mmps != GPSDATA_FIXED_UNSET) {
+        rec->speed_cmps = gpsdata_binlog_u16((double)fix->speed_mmps / 10.0);
+        rec->flags |= GPSDATA_BINLOG_HAS_SPEED;
+    }
+    if (!isnan(fix->course_degrees)) {
+        rec->course_cdeg = gpsdata_binlog_u16((double)fix->course_degrees * 100.0);
+        rec->flags |= GPSDATA_BINLOG_HAS_COURSE;
+    }
+    if (!isnan(fix->hdop)) {
+        rec->hdop_centi = gpsdata_binlog_u16((double)fix->hdop * 100.0);
+        rec->flags |= GPSDATA_BINLOG_HAS_HDOP;
+    }
+    if (fix->fused_msgids != 0)
+        rec->flags |= GPSDATA_BINLOG_FUSED;
+    rec->msgid = fix->msgid;
+    rec->posfix = fix->posfix;
+    rec->mode = fix->mode;
+    rec->num_satellites = fix->num_satellites;
+}
+
+void gpsdata_binlog_record_to_fix(const gpsdata_binlog_record_t *rec, gpsdata_fix_t *fix)
+{
+    if (!rec || !fix)
+        return;
+    uint16_t flags = rec->flags;
+    fix->timestamp_usec = (flags & GPSDATA_BINLOG_HAS_TIME) ? rec->timestamp_usec : 0;
+    if (flags & GPSDATA_BINLOG_HAS_POSITION) {
+        fix->latitude_e7 = rec->latitude_e7;
+        fix->longitude_e7 = rec->longitude_e7;
+    } else {
+        fix->latitude_e7 = GPSDATA_FIXED_UNSET;
+        fix->longitude_e7 = GPSDATA_FIXED_UNSET;
+    }
+    fix->altitude_mm = (flags & GPSDATA_BINLOG_HAS_ALTITUDE) ?
+                        rec->altitude_mm : GPSDATA_FIXED_UNSET;
+    fix->speed_mmps = (flags & GPSDATA_BINLOG_HAS_SPEED) ?
+                        (int32_t)rec->speed_cmps * 10 : GPSDATA_FIXED_UNSET;
+    fix->course_degrees = (flags & GPSDATA_BINLOG_HAS_COURSE) ?
+                        (float)rec->course_cdeg / 100.0f : NAN;
+    fix->hdop = (flags & GPSDATA_BINLOG_HAS_HDOP) ?
+                        (float)rec->hdop_centi / 100.0f : NAN;
+    // the individual messages are not stored
+    fix->fused_msgids = (flags & GPSDATA_BINLOG_FUSED) ?
+                        GPSDATA_MSGID_MASK(rec->msgid) : 0;
+    fix->msgid = rec->msgid;
+    fix->posfix = rec->posfix;
+    fix->mode = rec->mode;
+    fix->num_satellites = rec->num_satellites;
+}
+
+static int gpsdata_binlog_check_header(const gpsdata_binlog_header_t *in, const char *path)
+{
+    gpsdata_binlog_header_t hdr;
+    memcpy(&hdr, in, sizeof(hdr));
+    gpsdata_binlog_swap_header(&hdr);
+    if (memcmp(hdr.magic, GPSDATA_BINLOG_MAGIC, sizeof(GPSDATA_BINLOG_MAGIC)) != 0) {
+        GPSUTILS_ERROR("%s is not a binary fix log\n", path);
+        return -1;
+    }
+    if (hdr.version != GPSDATA_BINLOG_VERSION ||
+        hdr.record_size != sizeof(gpsdata_binlog_record_t)) {
+        GPSUTILS_ERROR("%s has unsupported version %u with %u byte records\n",
+                path, hdr.version, hdr.record_size);
+        return -1;
+    }
+    return 0;
+}
+
+static int gpsdata_binlog_write_all(int fd, const void *buf, size_t len)
+{
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t nb = write(fd, p, len);
+        if (nb < 0) {
+            int err = errno;
+            if (err == EINTR)
+                continue;
+            GPSUTILS_ERROR("Failed to write %zu bytes: %s(%d)\n", len, strerror(err), err);
+            return -1;
+        }
+        p += nb;
+        len -= (size_t)nb;
+    }
+    return 0;
+}
+
+struct gpsdata_binlog_writer_t {
+    int fd;
+    gpsdata_binlog_record_t *batch;
+    size_t capacity;
+    size_t count;
+    // the size of the file, always at a record boundary
+    off_t size;
+    // a failed write could not be cut back off, so nothing more is appended
+    bool broken;
+};
+
+gpsdata_binlog_writer_t *gpsdata_binlog_writer_open(const char *path, size_t batch_records)
+{
+    if (!path) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return NULL;
+    }
+    if (batch_records == 0)
+        batch_records = GPSDATA_BINLOG_DEFAULT_BATCH;
+    gpsdata_binlog_writer_t *w = calloc(1, sizeof(*w));
+    if (!w) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*w));
+        return NULL;
+    }
+    w->batch = calloc(batch_records, sizeof(*(w->batch)));
+    if (!w->batch) {
+        GPSUTILS_ERROR_NOMEM(batch_records * sizeof(*(w->batch)));
+        GPSUTILS_FREE(w);
+        return NULL;
+    }
+    w->capacity = batch_records;
+    w->fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC,
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (w->fd < 0) {
+        int err = errno;
+        GPSUTILS_ERROR("Failed to open %s: %s(%d)\n", path, strerror(err), err);
+        GPSUTILS_FREE(w->batch);
+        GPSUTILS_FREE(w);
+        return NULL;
+    }
+    int rc = 0;
+    do {
+        struct stat st;
+        if (fstat(w->fd, &st) < 0) {
+            int err = errno;
+            GPSUTILS_ERROR("Failed to stat %s: %s(%d)\n", path, strerror(err), err);
+            rc = -1;
+            break;
+        }
+        gpsdata_binlog_header_t hdr;
+        if (st.st_size == 0) {
+            struct timeval tv = { 0 };
+            gettimeofday(&tv, NULL);
+            memset(&hdr, 0, sizeof(hdr));
+            memcpy(hdr.magic, GPSDATA_BINLOG_MAGIC, sizeof(GPSDATA_BINLOG_MAGIC));
+            hdr.version = GPSDATA_BINLOG_VERSION;
+            hdr.record_size = sizeof(gpsdata_binlog_record_t);
+            hdr.created_usec = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+            gpsdata_binlog_swap_header(&hdr);
+            rc = gpsdata_binlog_write_all(w->fd, &hdr, sizeof(hdr));
+            w->size = (off_t)sizeof(hdr);
+            break;
+        }
+        if ((size_t)st.st_size < sizeof(hdr) ||
+            pread(w->fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+            gpsdata_binlog_check_header(&hdr, path) < 0) {
+            GPSUTILS_ERROR("Cannot append to %s\n", path);
+            rc = -1;
+            break;
+        }
+        size_t extra = ((size_t)st.st_size - sizeof(hdr)) % sizeof(gpsdata_binlog_record_t);
+        w->size = st.st_size - (off_t)extra;
+        if (extra != 0) {
+            // an earlier writer stopped in the middle of a record
+            GPSUTILS_WARN("Cutting off a partial record of %zu bytes at the end of %s\n",
+                    extra, path);
+            if (ftruncate(w->fd, st.st_size - (off_t)extra) < 0) {
+                int err = errno;
+                GPSUTILS_ERROR("Failed to truncate %s: %s(%d)\n", path, strerror(err), err);
+                rc = -1;
+            }
+        }
+    } while (0);
+    if (rc < 0) {
+        close(w->fd);
+        GPSUTILS_FREE(w->batch);
+        GPSUTILS_FREE(w);
+        return NULL;
+    }
+    return w;
+}
+
+int gpsdata_binlog_writer_flush(gpsdata_binlog_writer_t *w)
+{
+    if (!w)
+        return -1;
+    if (w->broken) {
+        GPSUTILS_ERROR("Not writing to a binary fix log with a partial record\n");
+        return -1;
+    }
+    if (w->count == 0)
+        return 0;
+    size_t len = w->count * sizeof(*(w->batch));
+    if (gpsdata_binlog_write_all(w->fd, w->batch, len) < 0) {
+        // a part of the batch may have been appended, so cut it back off to
+        // keep the records aligned. the batch is kept for the next flush
+        if (ftruncate(w->fd, w->size) < 0) {
+            int err = errno;
+            GPSUTILS_ERROR("Failed to truncate to %jd bytes: %s(%d)\n",
+                    (intmax_t)w->size, strerror(err), err);
+            w->broken = true;
+        }
+        return -1;
+    }
+    w->size += (off_t)len;
+    w->count = 0;
+    return 0;
+}
+
+int gpsdata_binlog_writer_append(gpsdata_binlog_writer_t *w, const gpsdata_fix_t *fix)
+{
+    if (!w || !fix || w->broken)
+        return -1;
+    // the batch is still full if its last flush failed
+    if (w->count == w->capacity && gpsdata_binlog_writer_flush(w) < 0)
+        return -1;
+    gpsdata_binlog_record_t *rec = &(w->batch[w->count++]);
+    gpsdata_binlog_record_from_fix(rec, fix);
+    gpsdata_binlog_swap_record(rec);
+    if (w->count == w->capacity && gpsdata_binlog_writer_flush(w) < 0) {
+        GPSUTILS_WARN("Keeping %zu records to write later\n", w->count);
+    }
+    return 0;
+}
+
+int gpsdata_binlog_writer_append_list(gpsdata_binlog_writer_t *w,
+            const gpsdata_data_t *listp)
+{
+    if (!w)
+        return -1;
+    for (const gpsdata_data_t *item = listp; item; item = item->next) {
+        gpsdata_fix_t fix;
+        gpsdata_fix_from_data(&fix, item);
+        if (gpsdata_binlog_writer_append(w, &fix) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int gpsdata_binlog_writer_close(gpsdata_binlog_writer_t *w)
+{
+    if (!w)
+        return -1;
+    int rc = gpsdata_binlog_writer_flush(w);
+    close(w->fd);
+    GPSUTILS_FREE(w->batch);
+    GPSUTILS_FREE(w);
+    return rc;
+}
+
+struct gpsdata_binlog_reader_t {
+    void *addr;
+    size_t len;
+    const gpsdata_binlog_record_t *records;
+    size_t count;
+    gpsdata_binlog_record_t *swapped; // byte swapped copy on big-endian hosts
+};
+
+gpsdata_binlog_reader_t *gpsdata_binlog_reader_open(const char *path)
+{
+    if (!path) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        int err = errno;
+        GPSUTILS_ERROR("Failed to open %s: %s(%d)\n", path, strerror(err), err);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int err = errno;
+        GPSUTILS_ERROR("Failed to stat %s: %s(%d)\n", path, strerror(err), err);
+        close(fd);
+        return NULL;
+    }
+    if ((size_t)st.st_size < sizeof(gpsdata_binlog_header_t)) {
+        GPSUTILS_ERROR("%s is too short to be a binary fix log\n", path);
+        close(fd);
+        return NULL;
+    }
+    size_t len = (size_t)st.st_size;
+    void *addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        int err = errno;
+        GPSUTILS_ERROR("Failed to mmap %s: %s(%d)\n", path, strerror(err), err);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+    if (gpsdata_binlog_check_header((const gpsdata_binlog_header_t *)addr, path) < 0) {
+        munmap(addr, len);
+        return NULL;
+    }
+    gpsdata_binlog_reader_t *r = calloc(1, sizeof(*r));
+    if (!r) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*r));
+        munmap(addr, len);
+        return NULL;
+    }
+    r->addr = addr;
+    r->len = len;
+    size_t body = len - sizeof(gpsdata_binlog_header_t);
+    r->count = body / sizeof(gpsdata_binlog_record_t);
+    if (body % sizeof(gpsdata_binlog_record_t) != 0) {
+        GPSUTILS_WARN("Ignoring a partial record at the end of %s\n", path);
+    }
+    r->records = (const gpsdata_binlog_record_t *)((const char *)addr +
+                    sizeof(gpsdata_binlog_header_t));
+    madvise(addr, len, MADV_SEQUENTIAL);
+#ifdef GPSDATA_BINLOG_SWAP
+    if (r->count > 0) {
+        r->swapped = calloc(r->count, sizeof(*(r->swapped)));
+        if (!r->swapped) {
+            GPSUTILS_ERROR_NOMEM(r->count * sizeof(*(r->swapped)));
+            munmap(addr, len);
+            GPSUTILS_FREE(r);
+            return NULL;
+        }
+        memcpy(r->swapped, r->records, r->count * sizeof(*(r->swapped)));
+        for (size_t i = 0; i < r->count; ++i)
+            gpsdata_binlog_swap_record(&(r->swapped[i]));
+        r->records = r->swapped;
+    }
+#endif
+    return r;
+}
+
+const gpsdata_binlog_record_t *gpsdata_binlog_reader_records(
+            const gpsdata_binlog_reader_t *r, size_t *count)
+{
+    if (count)
+        *count = r ? r->count : 0;
+    return r ? r->records : NULL;
+}
+
+void gpsdata_binlog_reader_close(gpsdata_binlog_reader_t *r)
+{
+    if (r) {
+        munmap(r->addr, r->len);
+        GPSUTILS_FREE(r->swapped);
+        GPSUTILS_FREE(r);
+    }
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+
+// "$PMTK" + body + "*XX\r\n" with room for the longest PMTK314 commands
+#define GPSDEVICE_CMD_MAX_LENGTH 128
+
+typedef struct gpsdevice_cmd_t {
+    uint16_t id;
+    bool in_flight;
+    uint8_t attempts;
+    uint64_t sent_ms;
+    gpsdevice_cmd_cb_t cb;
+    void *userdata;
+    char msg[GPSDEVICE_CMD_MAX_LENGTH];
+    struct gpsdevice_cmd_t *next;
+} gpsdevice_cmd_t;
+
+struct gpsdevice_cmdq_t {
+    int fd;
+    uint32_t timeout_ms;
+    uint8_t retries;
+    size_t max_inflight;
+    size_t inflight;
+    size_t count;
+    // commands are queued here instead of written to fd if set
+    gpsdevice_writer_t *writer;
+    // in the order of submission
+    gpsdevice_cmd_t *cmds;
+};
+
+const char *gpsdevice_cmd_status_tostring(gpsdevice_cmd_status_t st)
+{
+    switch (st) {
+    case GPSDEVICE_CMD_INVALID: return "INVALID";
+    case GPSDEVICE_CMD_UNSUPPORTED: return "UNSUPPORTED";
+    case GPSDEVICE_CMD_FAILED: return "FAILED";
+    case GPSDEVICE_CMD_SUCCESS: return "SUCCESS";
+    case GPSDEVICE_CMD_TIMEDOUT: return "TIMEDOUT";
+    case GPSDEVICE_CMD_CANCELLED: return "CANCELLED";
+    default: break;
+    }
+    return "UNKNOWN";
+}
+
+gpsdevice_cmdq_t *gpsdevice_cmdq_create(int fd, uint32_t timeout_ms,
+                uint8_t retries, size_t max_inflight)
+{
+    if (fd < 0)
+        return NULL;
+    gpsdevice_cmdq_t *q = calloc(1, sizeof(*q));
+    if (!q) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*q));
+        return NULL;
+    }
+    q->fd = fd;
+    q->timeout_ms = timeout_ms > 0 ? timeout_ms : GPSDEVICE_CMDQ_DEFAULT_TIMEOUT_MS;
+    q->retries = retries;
+    q->max_inflight = max_inflight > 0 ? max_inflight : GPSDEVICE_CMDQ_DEFAULT_INFLIGHT;
+    return q;
+}
+
+static void gpsdevice_cmdq_internal_unlink(gpsdevice_cmdq_t *q, gpsdevice_cmd_t *c)
+{
+    LL_DELETE(q->cmds, c);
+    q->count--;
+    if (c->in_flight)
+        q->inflight--;
+}
+
+// c must be off the list since the callback may submit or complete commands
+static void gpsdevice_cmdq_internal_finish(gpsdevice_cmd_t *c,
+                gpsdevice_cmd_status_t status)
+{
+    GPSUTILS_DEBUG("PMTK%03u completed with %s after %u attempt(s)\n",
+            c->id, gpsdevice_cmd_status_tostring(status), c->attempts);
+    if (c->cb)
+        c->cb(c->id, status, c->userdata);
+    GPSUTILS_FREE(c);
+}
+
+static void gpsdevice_cmdq_internal_complete(gpsdevice_cmdq_t *q,
+                gpsdevice_cmd_t *c, gpsdevice_cmd_status_t status)
+{
+    gpsdevice_cmdq_internal_unlink(q, c);
+    gpsdevice_cmdq_internal_finish(c, status);
+}
+
+void gpsdevice_cmdq_free(gpsdevice_cmdq_t *q)
+{
+    if (q) {
+        while (q->cmds)
+            gpsdevice_cmdq_internal_complete(q, q->cmds, GPSDEVICE_CMD_CANCELLED);
+        GPSUTILS_FREE(q);
+    }
+}
+
+int gpsdevice_cmdq_set_writer(gpsdevice_cmdq_t *q, gpsdevice_writer_t *w)
+{
+    if (!q)
+        return -1;
+    q->writer = w;
+    return 0;
+}
+
+static bool gpsdevice_cmdq_internal_id_in_flight(const gpsdevice_cmdq_t *q,
+                uint16_t id)
+{
+    const gpsdevice_cmd_t *c = NULL;
+    LL_FOREACH(q->cmds, c) {
+        if (c->in_flight && c->id == id)
+            return true;
+    }
+    return false;
+}
+
+static void gpsdevice_cmdq_internal_send(gpsdevice_cmdq_t *q, gpsdevice_cmd_t *c,
+                uint64_t now_ms)
+{
+    // a failed write counts as an attempt and is retried at the timeout
+    int rc = q->writer ? gpsdevice_writer_queue(q->writer, c->msg) :
+                gpsdevice_send_message(q->fd, c->msg);
+    if (rc < 0) {
+        GPSUTILS_WARN("Failed to send PMTK%03u, attempt %u\n", c->id,
+                c->attempts + 1);
+    }
+    if (!c->in_flight)
+        q->inflight++;
+    c->in_flight = true;
+    c->attempts++;
+    c->sent_ms = now_ms;
+}
+
+static void gpsdevice_cmdq_internal_dispatch(gpsdevice_cmdq_t *q, uint64_t now_ms)
+{
+    gpsdevice_cmd_t *c = NULL;
+    LL_FOREACH(q->cmds, c) {
+        if (q->inflight >= q->max_inflight)
+            break;
+        if (c->in_flight || gpsdevice_cmdq_internal_id_in_flight(q, c->id))
+            continue;
+        gpsdevice_cmdq_internal_send(q, c, now_ms);
+    }
+}
+
+int gpsdevice_cmdq_submit(gpsdevice_cmdq_t *q, const char *msg,
+                gpsdevice_cmd_cb_t cb, void *userdata)
+{
+    if (!q || !msg)
+        return -1;
+    if (strncmp(msg, "PMTK", 4) != 0 || !isdigit((unsigned char)msg[4])) {
+        GPSUTILS_ERROR("Not a PMTK command: %s\n", msg);
+        return -1;
+    }
+    unsigned long id = 0;
+    const char *p = msg + 4;
+    for (; isdigit((unsigned char)*p) && id <= 999; ++p)
+        id = id * 10 + (unsigned long)(*p - '0');
+    if (id > 999 || (*p != '\0' && *p != ',')) {
+        GPSUTILS_ERROR("Invalid PMTK command ID in %s\n", msg);
+        return -1;
+    }
+    gpsdevice_cmd_t *c = calloc(1, sizeof(*c));
+    if (!c) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*c));
+        return -1;
+    }
+    int n = snprintf(c->msg, sizeof(c->msg), "$%s*%02X\r\n", msg,
+                    gpsutils_checksum(msg, -1));
+    if (n < 0 || (size_t)n >= sizeof(c->msg)) {
+        GPSUTILS_ERROR("PMTK command is too long: %s\n", msg);
+        GPSUTILS_FREE(c);
+        return -1;
+    }
+    c->id = (uint16_t)id;
+    c->cb = cb;
+    c->userdata = userdata;
+    LL_APPEND(q->cmds, c);
+    q->count++;
+    gpsdevice_cmdq_internal_dispatch(q, gpsutils_monotonic_ms());
+    return 0;
+}
+
+int gpsdevice_cmdq_ack(gpsdevice_cmdq_t *q, uint16_t cmd, uint8_t flag)
+{
+    if (!q)
+        return -1;
+    gpsdevice_cmd_t *c = NULL;
+    LL_FOREACH(q->cmds, c) {
+        if (c->in_flight && c->id == cmd)
+            break;
+    }
+    if (!c) {
+        GPSUTILS_DEBUG("Unexpected PMTK001 for command %u flag %u\n", cmd, flag);
+        return -1;
+    }
+    gpsdevice_cmd_status_t status = (flag <= GPSDEVICE_CMD_SUCCESS) ?
+                        (gpsdevice_cmd_status_t)flag : GPSDEVICE_CMD_FAILED;
+    gpsdevice_cmdq_internal_complete(q, c, status);
+    gpsdevice_cmdq_internal_dispatch(q, gpsutils_monotonic_ms());
+    return 0;
+}
+
+void gpsdevice_cmdq_parser_ack(uint16_t cmd, uint8_t flag, void *cmdq)
+{
+    gpsdevice_cmdq_ack((gpsdevice_cmdq_t *)cmdq, cmd, flag);
+}
+
+int gpsdevice_cmdq_poll(gpsdevice_cmdq_t *q)
+{
+    if (!q)
+        return -1;
+    uint64_t now_ms = gpsutils_monotonic_ms();
+    gpsdevice_cmd_t *c = NULL;
+    gpsdevice_cmd_t *tmp = NULL;
+    gpsdevice_cmd_t *timedout = NULL;
+    LL_FOREACH_SAFE(q->cmds, c, tmp) {
+        if (!c->in_flight || (now_ms - c->sent_ms) < q->timeout_ms)
+            continue;
+        if (c->attempts <= q->retries) {
+            GPSUTILS_DEBUG("PMTK%03u not acknowledged in %u ms, resending\n",
+                    c->id, q->timeout_ms);
+            gpsdevice_cmdq_internal_send(q, c, now_ms);
+        } else {
+            GPSUTILS_WARN("PMTK%03u not acknowledged after %u attempt(s)\n",
+                    c->id, c->attempts);
+            gpsdevice_cmdq_internal_unlink(q, c);
+            LL_APPEND(timedout, c);
+        }
+    }
+    gpsdevice_cmdq_internal_dispatch(q, now_ms);
+    // a callback may complete other commands, which would free the next
+    // node of the loop above, so they run once the walk is over
+    LL_FOREACH_SAFE(timedout, c, tmp) {
+        LL_DELETE(timedout, c);
+        gpsdevice_cmdq_internal_finish(c, GPSDEVICE_CMD_TIMEDOUT);
+    }
+    return (int)q->count;
+}
+
+size_t gpsdevice_cmdq_pending(const gpsdevice_cmdq_t *q)
+{
+    return q ? q->count : 0;
+}
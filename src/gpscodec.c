@@ -0,0 +1,193 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+
+/** NOTE: a fix is mapped to integer channels. Unset fixed-point fields keep
+ * their GPSDATA_FIXED_UNSET value and unset float fields become -1, so the
+ * mapping is lossless for everything the NMEA messages carry **/
+
+enum {
+    GPSDATA_CODEC_TIMESTAMP,
+    GPSDATA_CODEC_LATITUDE,
+    GPSDATA_CODEC_LONGITUDE,
+    GPSDATA_CODEC_ALTITUDE,
+    GPSDATA_CODEC_SPEED,
+    GPSDATA_CODEC_COURSE, // 0.01 degrees
+    GPSDATA_CODEC_HDOP, // 0.01
+    GPSDATA_CODEC_MSGID,
+    GPSDATA_CODEC_POSFIX,
+    GPSDATA_CODEC_MODE,
+    GPSDATA_CODEC_NUM_SATELLITES,
+    GPSDATA_CODEC_FUSED_MSGIDS
+};
+
+static int64_t gpsdata_codec_from_float(float v)
+{
+    return isnan(v) ? -1 : (int64_t)llroundf(v * 100.0f);
+}
+
+static float gpsdata_codec_to_float(int64_t v)
+{
+    return (v < 0) ? NAN : (float)v / 100.0f;
+}
+
+static void gpsdata_codec_to_channels(const gpsdata_fix_t *fix, int64_t *ch)
+{
+    ch[GPSDATA_CODEC_TIMESTAMP] = fix->timestamp_usec;
+    ch[GPSDATA_CODEC_LATITUDE] = fix->latitude_e7;
+    ch[GPSDATA_CODEC_LONGITUDE] = fix->longitude_e7;
+    ch[GPSDATA_CODEC_ALTITUDE] = fix->altitude_mm;
+    ch[GPSDATA_CODEC_SPEED] = fix->speed_mmps;
+    ch[GPSDATA_CODEC_COURSE] = gpsdata_codec_from_float(fix->course_degrees);
+    ch[GPSDATA_CODEC_HDOP] = gpsdata_codec_from_float(fix->hdop);
+    ch[GPSDATA_CODEC_MSGID] = fix->msgid;
+    ch[GPSDATA_CODEC_POSFIX] = fix->posfix;
+    ch[GPSDATA_CODEC_MODE] = fix->mode;
+    ch[GPSDATA_CODEC_NUM_SATELLITES] = fix->num_satellites;
+    ch[GPSDATA_CODEC_FUSED_MSGIDS] = fix->fused_msgids;
+}
+
+static void gpsdata_codec_from_channels(const int64_t *ch, gpsdata_fix_t *fix)
+{
+    fix->timestamp_usec = ch[GPSDATA_CODEC_TIMESTAMP];
+    fix->latitude_e7 = (int32_t)ch[GPSDATA_CODEC_LATITUDE];
+    fix->longitude_e7 = (int32_t)ch[GPSDATA_CODEC_LONGITUDE];
+    fix->altitude_mm = (int32_t)ch[GPSDATA_CODEC_ALTITUDE];
+    fix->speed_mmps = (int32_t)ch[GPSDATA_CODEC_SPEED];
+    fix->course_degrees = gpsdata_codec_to_float(ch[GPSDATA_CODEC_COURSE]);
+    fix->hdop = gpsdata_codec_to_float(ch[GPSDATA_CODEC_HDOP]);
+    fix->msgid = (uint8_t)ch[GPSDATA_CODEC_MSGID];
+    fix->posfix = (uint8_t)ch[GPSDATA_CODEC_POSFIX];
+    fix->mode = (uint8_t)ch[GPSDATA_CODEC_MODE];
+    fix->num_satellites = (uint8_t)ch[GPSDATA_CODEC_NUM_SATELLITES];
+    fix->fused_msgids = (uint32_t)ch[GPSDATA_CODEC_FUSED_MSGIDS];
+}
+
+static void gpsdata_codec_reset(gpsdata_codec_t *codec)
+{
+    memset(codec->prev, 0, sizeof(codec->prev));
+    codec->prev_step = 0;
+    codec->count = 0;
+}
+
+void gpsdata_codec_init(gpsdata_codec_t *codec, uint32_t restart_interval)
+{
+    if (codec) {
+        gpsdata_codec_reset(codec);
+        codec->restart_interval = (restart_interval > 0) ? restart_interval :
+                                    GPSDATA_CODEC_DEFAULT_RESTART;
+    }
+}
+
+static int64_t gpsdata_codec_predict(const gpsdata_codec_t *codec, int i)
+{
+    // the differences wrap like the decoder's additions do
+    if (i == GPSDATA_CODEC_TIMESTAMP)
+        return (int64_t)((uint64_t)codec->prev[i] + (uint64_t)codec->prev_step);
+    return codec->prev[i];
+}
+
+static void gpsdata_codec_advance(gpsdata_codec_t *codec, const int64_t *ch)
+{
+    codec->prev_step = (int64_t)((uint64_t)ch[GPSDATA_CODEC_TIMESTAMP] -
+                        (uint64_t)codec->prev[GPSDATA_CODEC_TIMESTAMP]);
+    memcpy(codec->prev, ch, sizeof(codec->prev));
+    codec->count++;
+}
+
+static size_t gpsdata_codec_put_varint(uint8_t *out, uint64_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+// returns the bytes used, 0 if the input ends early and -1 if it is too long
+static int gpsdata_codec_get_varint(const uint8_t *in, size_t inlen, uint64_t *v)
+{
+    uint64_t result = 0;
+    for (size_t n = 0; n < 10; ++n) {
+        if (n >= inlen)
+            return 0;
+        result |= (uint64_t)(in[n] & 0x7F) << (7 * n);
+        if (!(in[n] & 0x80)) {
+            *v = result;
+            return (int)(n + 1);
+        }
+    }
+    return -1;
+}
+
+int gpsdata_codec_encode(gpsdata_codec_t *codec, const gpsdata_fix_t *fix,
+            uint8_t *out, size_t outlen, bool *restart)
+{
+    if (!codec || !fix || !out || outlen < GPSDATA_CODEC_MAX_RECORD)
+        return -1;
+    if (codec->count >= codec->restart_interval)
+        gpsdata_codec_reset(codec);
+    if (restart)
+        *restart = (codec->count == 0);
+    int64_t ch[GPSDATA_CODEC_CHANNELS];
+    uint64_t diff[GPSDATA_CODEC_CHANNELS];
+    uint32_t bitmap = 0;
+    gpsdata_codec_to_channels(fix, ch);
+    for (int i = 0; i < GPSDATA_CODEC_CHANNELS; ++i) {
+        uint64_t d = (uint64_t)ch[i] - (uint64_t)gpsdata_codec_predict(codec, i);
+        if (d != 0) {
+            bitmap |= UINT32_C(1) << i;
+            // zigzag keeps small negative differences small
+            diff[i] = (d << 1) ^ (uint64_t)((int64_t)d >> 63);
+        }
+    }
+    size_t n = gpsdata_codec_put_varint(out, bitmap);
+    for (int i = 0; i < GPSDATA_CODEC_CHANNELS; ++i) {
+        if (bitmap & (UINT32_C(1) << i))
+            n += gpsdata_codec_put_varint(out + n, diff[i]);
+    }
+    gpsdata_codec_advance(codec, ch);
+    return (int)n;
+}
+
+int gpsdata_codec_decode(gpsdata_codec_t *codec, const uint8_t *in, size_t inlen,
+            gpsdata_fix_t *fix)
+{
+    if (!codec || !in || !fix)
+        return -1;
+    uint64_t bitmap = 0;
+    int rc = gpsdata_codec_get_varint(in, inlen, &bitmap);
+    if (rc <= 0)
+        return rc;
+    if (bitmap >> GPSDATA_CODEC_CHANNELS) {
+        GPSUTILS_WARN("Invalid codec field bitmap 0x%" PRIx64 "\n", bitmap);
+        return -1;
+    }
+    // nothing changes until the whole record is there
+    gpsdata_codec_t next = *codec;
+    if (next.count >= next.restart_interval)
+        gpsdata_codec_reset(&next);
+    size_t n = (size_t)rc;
+    int64_t ch[GPSDATA_CODEC_CHANNELS];
+    for (int i = 0; i < GPSDATA_CODEC_CHANNELS; ++i) {
+        uint64_t d = 0;
+        if (bitmap & (UINT64_C(1) << i)) {
+            uint64_t zz = 0;
+            rc = gpsdata_codec_get_varint(in + n, inlen - n, &zz);
+            if (rc <= 0)
+                return rc;
+            n += (size_t)rc;
+            d = (zz >> 1) ^ (0 - (zz & 1));
+        }
+        ch[i] = (int64_t)((uint64_t)gpsdata_codec_predict(&next, i) + d);
+    }
+    gpsdata_codec_advance(&next, ch);
+    *codec = next;
+    gpsdata_codec_from_channels(ch, fix);
+    return (int)n;
+}
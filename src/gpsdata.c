@@ -16,6 +16,9 @@
 #ifdef LIBGPS_MTK3339_HAVE_TERMIOS_H
     #include <termios.h>
 #endif
+#ifdef LIBGPS_MTK3339_HAVE_POLL_H
+    #include <poll.h>
+#endif
 #ifdef LIBGPS_MTK3339_HAVE_DECL_STRERROR_R
 // do nothing
 #else
@@ -95,6 +98,24 @@ const char *gpsdata_antenna_tostring(gpsdata_antenna_t a)
     return "UNSET";
 }
 
+double gpsdata_latlon_to_degrees(const gpsdata_latlon_t *ll)
+{
+    if (!ll || ll->direction == GPSDATA_DIRECTION_UNSET)
+        return NAN;
+    double deg = (double)ll->degrees + ((double)ll->minutes / 60.0);
+    if (ll->direction == GPSDATA_DIRECTION_SOUTH ||
+        ll->direction == GPSDATA_DIRECTION_WEST)
+        deg = -deg;
+    return deg;
+}
+
+double gpsdata_fixed_to_double(int32_t value, int32_t scale)
+{
+    if (value == GPSDATA_FIXED_UNSET || scale == 0)
+        return NAN;
+    return (double)value / (double)scale;
+}
+
 void gpsdata_list_free(gpsdata_data_t **listp)
 {
     if (listp) {
@@ -102,6 +123,10 @@ void gpsdata_list_free(gpsdata_data_t **listp)
         gpsdata_data_t *tmp = NULL;
         LL_FOREACH_SAFE(*listp, item, tmp) {
             LL_DELETE(*listp, item);
+            if (item && item->pool) {
+                gpsdata_pool_put(item);
+                continue;
+            }
             if (item) {
                 GPSUTILS_FREE(item->fwinfo.firmware);
                 GPSUTILS_FREE(item->fwinfo.build_id);
@@ -113,6 +138,128 @@ void gpsdata_list_free(gpsdata_data_t **listp)
     }
 }
 
+typedef struct gpsdata_pool_slab_t {
+    struct gpsdata_pool_slab_t *next;
+    gpsdata_data_t items[];
+} gpsdata_pool_slab_t;
+
+struct gpsdata_pool_t {
+    gpsdata_data_t *freelist;
+    gpsdata_pool_slab_t *slabs;
+    size_t slab_items;
+    size_t capacity;
+    size_t available;
+    uint64_t hits;
+    uint64_t misses;
+    // set by gpsdata_pool_free() if items are still in use
+    bool is_released;
+};
+
+static int gpsdata_pool_grow(gpsdata_pool_t *pool)
+{
+    size_t sz = sizeof(gpsdata_pool_slab_t) + pool->slab_items * sizeof(gpsdata_data_t);
+    gpsdata_pool_slab_t *slab = calloc(1, sz);
+    if (!slab) {
+        GPSUTILS_ERROR_NOMEM(sz);
+        return -1;
+    }
+    LL_PREPEND(pool->slabs, slab);
+    for (size_t i = 0; i < pool->slab_items; ++i) {
+        gpsdata_data_t *item = &(slab->items[i]);
+        item->pool = pool;
+        LL_PREPEND(pool->freelist, item);
+    }
+    pool->capacity += pool->slab_items;
+    pool->available += pool->slab_items;
+    GPSUTILS_DEBUG("Pool %p grew to %zu items\n", (void *)pool, pool->capacity);
+    return 0;
+}
+
+static void gpsdata_pool_destroy(gpsdata_pool_t *pool)
+{
+    gpsdata_pool_slab_t *slab = NULL;
+    gpsdata_pool_slab_t *tmp = NULL;
+    LL_FOREACH_SAFE(pool->slabs, slab, tmp) {
+        LL_DELETE(pool->slabs, slab);
+        GPSUTILS_FREE(slab);
+    }
+    GPSUTILS_FREE(pool);
+}
+
+gpsdata_pool_t *gpsdata_pool_create(size_t capacity)
+{
+    gpsdata_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*pool));
+        return NULL;
+    }
+    pool->slab_items = (capacity > 0) ? capacity : GPSDATA_POOL_DEFAULT_CAPACITY;
+    if (gpsdata_pool_grow(pool) < 0) {
+        GPSUTILS_FREE(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void gpsdata_pool_free(gpsdata_pool_t *pool)
+{
+    if (pool) {
+        if (pool->available == pool->capacity) {
+            gpsdata_pool_destroy(pool);
+        } else {
+            GPSUTILS_DEBUG("Pool %p has %zu items in use, deferring release\n",
+                    (void *)pool, pool->capacity - pool->available);
+            pool->is_released = true;
+        }
+    }
+}
+
+gpsdata_data_t *gpsdata_pool_get(gpsdata_pool_t *pool)
+{
+    if (!pool || pool->is_released)
+        return NULL;
+    if (!pool->freelist) {
+        pool->misses++;
+        if (gpsdata_pool_grow(pool) < 0)
+            return NULL;
+    } else {
+        pool->hits++;
+    }
+    gpsdata_data_t *item = pool->freelist;
+    pool->freelist = item->next;
+    pool->available--;
+    gpsdata_initialize(item);
+    item->pool = pool;
+    return item;
+}
+
+void gpsdata_pool_put(gpsdata_data_t *item)
+{
+    if (item && item->pool) {
+        gpsdata_pool_t *pool = item->pool;
+        GPSUTILS_FREE(item->fwinfo.firmware);
+        GPSUTILS_FREE(item->fwinfo.build_id);
+        GPSUTILS_FREE(item->fwinfo.chip_name);
+        GPSUTILS_FREE(item->fwinfo.chip_version);
+        LL_PREPEND(pool->freelist, item);
+        pool->available++;
+        if (pool->is_released && pool->available == pool->capacity) {
+            gpsdata_pool_destroy(pool);
+        }
+    }
+}
+
+int gpsdata_pool_get_stats(const gpsdata_pool_t *pool, gpsdata_pool_stats_t *stats)
+{
+    if (!pool || !stats)
+        return -1;
+    stats->hits = pool->hits;
+    stats->misses = pool->misses;
+    stats->capacity = pool->capacity;
+    stats->available = pool->available;
+    return 0;
+}
+
 ssize_t gpsdata_list_count(const gpsdata_data_t *listp)
 {
     if (listp) {
@@ -124,6 +271,50 @@ ssize_t gpsdata_list_count(const gpsdata_data_t *listp)
     return -1;
 }
 
+void gpsdata_list_init(gpsdata_list_t *list)
+{
+    if (list) {
+        list->head = list->tail = NULL;
+        list->count = 0;
+    }
+}
+
+void gpsdata_list_append(gpsdata_list_t *list, gpsdata_data_t *item)
+{
+    if (list && item) {
+        item->next = NULL;
+        if (list->tail) {
+            list->tail->next = item;
+        } else {
+            list->head = item;
+        }
+        list->tail = item;
+        list->count++;
+    }
+}
+
+void gpsdata_list_concat(gpsdata_list_t *dst, gpsdata_list_t *src)
+{
+    if (dst && src && src->head) {
+        if (dst->tail) {
+            dst->tail->next = src->head;
+        } else {
+            dst->head = src->head;
+        }
+        dst->tail = src->tail;
+        dst->count += src->count;
+        gpsdata_list_init(src);
+    }
+}
+
+void gpsdata_list_clear(gpsdata_list_t *list)
+{
+    if (list) {
+        gpsdata_list_free(&(list->head));
+        gpsdata_list_init(list);
+    }
+}
+
 void gpsdata_list_dump(const gpsdata_data_t *listp, FILE *fp)
 {
     if (listp) {
@@ -154,15 +345,49 @@ void gpsdata_initialize(gpsdata_data_t *o)
         o->speed_knots = NAN;
         o->course_degrees = NAN;
         o->heading_degrees = NAN;
+        o->latitude_e7 = GPSDATA_FIXED_UNSET;
+        o->longitude_e7 = GPSDATA_FIXED_UNSET;
+        o->altitude_mm = GPSDATA_FIXED_UNSET;
+        o->speed_mmps = GPSDATA_FIXED_UNSET;
+        o->dop.pdop = NAN;
+        o->dop.hdop = NAN;
+        o->dop.vdop = NAN;
+        o->gsa.selection = GPSDATA_MODE_UNSET;
+        o->gsa.fix = GPSDATA_MODE_UNSET;
+        o->gsa.num_used = 0;
+        memset(o->gsa.satellites_used, 0, sizeof(o->gsa.satellites_used));
+        o->fused_msgids = 0;
+        o->rx_usec = 0;
         o->antenna_status = GPSDATA_ANTENNA_UNSET;
         o->fwinfo.firmware = NULL;
         o->fwinfo.build_id = NULL;
         o->fwinfo.chip_name = NULL;
         o->fwinfo.chip_version = NULL;
+        o->pool = NULL;
         o->next = NULL;
     }
 }
 
+void gpsdata_fix_from_data(gpsdata_fix_t *fix, const gpsdata_data_t *o)
+{
+    if (fix && o) {
+        fix->timestamp_usec = o->is_valid_timestamp ?
+            ((int64_t)o->timestamp.tv_sec * 1000000 + o->timestamp.tv_usec) : 0;
+        fix->latitude_e7 = o->latitude_e7;
+        fix->longitude_e7 = o->longitude_e7;
+        fix->altitude_mm = o->altitude_mm;
+        fix->speed_mmps = o->speed_mmps;
+        fix->course_degrees = o->course_degrees;
+        fix->hdop = o->dop.hdop;
+        fix->fused_msgids = o->fused_msgids;
+        fix->msgid = (uint8_t)o->msgid;
+        fix->posfix = (uint8_t)o->posfix;
+        fix->mode = (uint8_t)o->mode;
+        fix->num_satellites = (o->num_satellites > UINT8_MAX) ? UINT8_MAX :
+                                (uint8_t)o->num_satellites;
+    }
+}
+
 void gpsdata_dump(const gpsdata_data_t *o, FILE *fp)
 {
     if (o && fp) {
@@ -183,6 +408,10 @@ void gpsdata_dump(const gpsdata_data_t *o, FILE *fp)
                 o->is_valid_timestamp ? "valid" : "incomplete",
                 o->timestamp.tv_sec, o->timestamp.tv_usec);
         }
+        if (o->rx_usec != 0) {
+            fprintf(fp, "received: %" PRId64 ".%06" PRId64 "\n",
+                o->rx_usec / 1000000, o->rx_usec % 1000000);
+        }
         if (o->mode != GPSDATA_MODE_UNSET) {
             fprintf(fp, "%s mode: %s\n", msgid_str, gpsdata_mode_tostring(o->mode));
         }
@@ -191,6 +420,18 @@ void gpsdata_dump(const gpsdata_data_t *o, FILE *fp)
                     gpsdata_posfix_tostring(o->posfix), o->num_satellites,
                     o->altitude_meters);
         }
+        if (!isnan(o->dop.pdop) || !isnan(o->dop.hdop) || !isnan(o->dop.vdop)) {
+            fprintf(fp, "PDOP: %0.02f HDOP: %0.02f VDOP: %0.02f\n",
+                    o->dop.pdop, o->dop.hdop, o->dop.vdop);
+        }
+        if (o->gsa.fix != GPSDATA_MODE_UNSET) {
+            fprintf(fp, "selection: %s fix: %s satellites used:",
+                    gpsdata_mode_tostring(o->gsa.selection),
+                    gpsdata_mode_tostring(o->gsa.fix));
+            for (uint8_t i = 0; i < o->gsa.num_used; ++i)
+                fprintf(fp, " %u", o->gsa.satellites_used[i]);
+            fprintf(fp, "\n");
+        }
         if (!isnan(o->speed_kmph)) {
             fprintf(fp, "speed: %0.04f km/hr\n", o->speed_kmph);
         }
@@ -274,23 +515,105 @@ int gpsdevice_send_message(int fd, const char *msg)
     size_t len = strlen(msg);
     if (len == 0)
             return -1;
-    ssize_t nb = write(fd, msg, len);
-    if (nb > 0) {
-        if ((size_t)nb == len) {
-            GPSUTILS_DEBUG("Wrote a message of %zu bytes: %s\n", nb, msg);
-        } else {
-            GPSUTILS_WARN("Wrote a message of %zu bytes, expected to write %zu bytes. Message: %s\n", nb, len, msg);
+    size_t off = 0;
+    while (off < len) {
+        ssize_t nb = write(fd, msg + off, len - off);
+        if (nb > 0) {
+            off += (size_t)nb;
+            continue;
+        }
+        int err = (nb < 0) ? errno : EAGAIN;
+        if (err == EINTR)
+            continue;
+        // a non-blocking fd waits for room so that the message is not cut
+        if (err == EAGAIN || err == EWOULDBLOCK) {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            int prc = poll(&pfd, 1, GPSDEVICE_SEND_TIMEOUT_MS);
+            if (prc > 0)
+                continue;
+            if (prc < 0 && errno == EINTR)
+                continue;
+            err = (prc == 0) ? ETIMEDOUT : errno;
         }
-        return 0;
-    } else {
-        int err = errno;
         char serrbuf[256];
         memset(serrbuf, 0, sizeof(serrbuf));
         strerror_r(err, serrbuf, sizeof(serrbuf) - 1);
-        GPSUTILS_ERROR("Failed to write message to fd: %d. Error: %s(%d)\n",
-                fd, serrbuf, err);
+        GPSUTILS_ERROR("Failed to write message to fd: %d after %zu of %zu bytes. Error: %s(%d)\n",
+                fd, off, len, serrbuf, err);
         return -1;
     }
+    GPSUTILS_DEBUG("Wrote a message of %zu bytes: %s\n", len, msg);
+    return 0;
+}
+
+static int gpsdevice_internal_baudspeed(uint32_t baud_rate, speed_t *baudspeed)
+{
+    switch (baud_rate) {
+    case 1200: *baudspeed = B1200; break;
+    case 2400: *baudspeed = B2400; break;
+    case 4800: *baudspeed = B4800; break;
+    case 9600: *baudspeed = B9600; break;
+    case 19200: *baudspeed = B19200; break;
+    case 38400: *baudspeed = B38400; break;
+    case 57600: *baudspeed = B57600; break;
+    case 115200: *baudspeed = B115200; break;
+    default: return -1;
+    }
+    return 0;
+}
+
+// sets the speed of the local side of the link only
+// queue is TCIFLUSH or TCIOFLUSH, the data that is dropped with the old speed
+static int gpsdevice_internal_set_speed(int fd, speed_t baudspeed, int queue)
+{
+    char serrbuf[256];
+    struct termios opts;
+    // get the terminal options on the fd
+    int rc = tcgetattr(fd, &opts);
+    if (rc < 0) {
+        int err = errno;
+        memset(serrbuf, 0, sizeof(serrbuf));
+        strerror_r(err, serrbuf, sizeof(serrbuf) - 1);
+        GPSUTILS_ERROR("tcgetattr(%d) error: %s(%d)\n", fd, serrbuf, err);
+        return -1;
+    }
+    //IGNPAR: ignore characters with parity errors
+    opts.c_iflag = IGNPAR;
+    //CS8 : 8-bit byte character size mask
+    //CLOCAL: ignore modem control lines
+    //CREAD: enable receiver
+    opts.c_cflag = baudspeed | CS8 | CLOCAL | CREAD;
+    opts.c_lflag = 0;
+    opts.c_oflag = 0;
+    rc = tcflush(fd, queue);
+    if (rc < 0) {
+        int err = errno;
+        memset(serrbuf, 0, sizeof(serrbuf));
+        strerror_r(err, serrbuf, sizeof(serrbuf) - 1);
+        GPSUTILS_WARN("tcflush(%d, %d) error: %s(%d). Ignoring\n", fd, queue, serrbuf, err);
+    }
+    rc = tcsetattr(fd, TCSANOW, &opts);
+    if (rc < 0) {
+        int err = errno;
+        memset(serrbuf, 0, sizeof(serrbuf));
+        strerror_r(err, serrbuf, sizeof(serrbuf) - 1);
+        GPSUTILS_ERROR("tcsetattr(%d, TCSANOW) error: %s(%d). Ignoring\n", fd, serrbuf, err);
+        return -1;
+    }
+    return 0;
+}
+
+static int gpsdevice_internal_send_baudrate(int fd, uint32_t baud_rate)
+{
+    char buf1[32];
+    char buf2[64];
+    memset(buf1, 0, sizeof(buf1));
+    memset(buf2, 0, sizeof(buf2));
+    snprintf(buf1, sizeof(buf1) - 1, "PMTK251,%u", baud_rate);
+    // no error check here because buf1 is not null and strlen(buf1) is > 0
+    snprintf(buf2, sizeof(buf2) - 1, "$%s*%02X\r\n", buf1,
+            gpsutils_checksum(buf1, -1));
+    return gpsdevice_send_message(fd, buf2);
 }
 
 int gpsdevice_set_baudrate(int fd, uint32_t baud_rate)
@@ -298,69 +621,119 @@ int gpsdevice_set_baudrate(int fd, uint32_t baud_rate)
     if (fd < 0)
         return -1;
     speed_t baudspeed = B9600;
-    switch (baud_rate) {
-    case 1200: baudspeed = B1200; break;
-    case 2400: baudspeed = B2400; break;
-    case 4800: baudspeed = B4800; break;
-    case 9600: baudspeed = B9600; break;
-    case 19200: baudspeed = B19200; break;
-    case 38400: baudspeed = B38400; break;
-    case 57600: baudspeed = B57600; break;
-    case 115200: baudspeed = B115200; break;
-    default:
+    if (gpsdevice_internal_baudspeed(baud_rate, &baudspeed) < 0) {
         GPSUTILS_WARN("Invalid baud rate %u bps given. Using 9600 bps\n", baud_rate);
         baudspeed = B9600;
         baud_rate = 9600;
-        break;
     }
-    int rc = 0;
-    do {
-        char serrbuf[256];
-        struct termios opts;
-        // get the terminal options on the fd
-        rc = tcgetattr(fd, &opts);
-        if (rc < 0) {
+    int rc = gpsdevice_internal_set_speed(fd, baudspeed, TCIOFLUSH);
+    if (rc == 0) {
+        GPSUTILS_DEBUG("Baud rate set to %d on fd %d\n", baud_rate, fd);
+        rc = gpsdevice_internal_send_baudrate(fd, baud_rate);
+    }
+    return rc;
+}
+
+/* waits up to timeout_ms for a message with a good checksum.
+ * returns 1 if one arrived, 0 on timeout and -1 on error */
+static int gpsdevice_internal_verify_link(int fd, uint32_t timeout_ms)
+{
+    char buf[GPSUTILS_NMEA_MAX_LENGTH * 2];
+    size_t len = 0;
+    uint64_t deadline = gpsutils_monotonic_ms() + timeout_ms;
+    while (1) {
+        uint64_t now = gpsutils_monotonic_ms();
+        if (now >= deadline)
+            return 0;
+        struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+        int prc = poll(&pfd, 1, (int)(deadline - now));
+        if (prc < 0) {
             int err = errno;
+            if (err == EINTR)
+                continue;
+            char serrbuf[256];
             memset(serrbuf, 0, sizeof(serrbuf));
             strerror_r(err, serrbuf, sizeof(serrbuf) - 1);
-            GPSUTILS_ERROR("tcgetattr(%d) error: %s(%d)\n", fd, serrbuf, err);
-            break;
+            GPSUTILS_ERROR("poll(%d) error: %s(%d)\n", fd, serrbuf, err);
+            return -1;
         }
-        //IGNPAR: ignore characters with parity errors
-        opts.c_iflag = IGNPAR;
-        //CS8 : 8-bit byte character size mask
-        //CLOCAL: ignore modem control lines
-        //CREAD: enable receiver
-        opts.c_cflag = baudspeed | CS8 | CLOCAL | CREAD;
-        opts.c_lflag = 0;
-        opts.c_oflag = 0;
-        rc = tcflush(fd, TCIOFLUSH);
-        if (rc < 0) {
+        if (prc == 0)
+            return 0;
+        ssize_t nb = read(fd, buf + len, sizeof(buf) - len);
+        if (nb < 0) {
             int err = errno;
+            if (err == EINTR || err == EAGAIN || err == EWOULDBLOCK)
+                continue;
+            char serrbuf[256];
             memset(serrbuf, 0, sizeof(serrbuf));
             strerror_r(err, serrbuf, sizeof(serrbuf) - 1);
-            GPSUTILS_WARN("tcflush(%d, TCIOFLUSH) error: %s(%d). Ignoring\n", fd, serrbuf, err);
+            GPSUTILS_ERROR("read(%d) error: %s(%d)\n", fd, serrbuf, err);
+            return -1;
         }
-        rc = tcsetattr(fd, TCSANOW, &opts);
-        if (rc < 0) {
-            int err = errno;
-            memset(serrbuf, 0, sizeof(serrbuf));
-            strerror_r(err, serrbuf, sizeof(serrbuf) - 1);
-            GPSUTILS_ERROR("tcsetattr(%d, TCSANOW) error: %s(%d). Ignoring\n", fd, serrbuf, err);
-            break;
+        if (nb == 0)
+            continue;
+        len += (size_t)nb;
+        // look for a whole message and keep a partial one for the next read
+        size_t keep = len;
+        for (size_t i = 0; i < len; ++i) {
+            if (buf[i] != '$')
+                continue;
+            int vrc = gpsutils_checksum_verify(buf + i, len - i, NULL);
+            if (vrc > 0)
+                return 1;
+            if (vrc < 0 && keep == len)
+                keep = i;
         }
-        GPSUTILS_DEBUG("Baud rate set to %d on fd %d\n", baud_rate, fd);
-        char buf1[32];
-        char buf2[64];
-        memset(buf1, 0, sizeof(buf1));
-        memset(buf2, 0, sizeof(buf2));
-        snprintf(buf1, sizeof(buf1) - 1, "PMTK251,%d", baud_rate);
-        // no error check here because buf1 is not null and strlen(buf1) is > 0
-        snprintf(buf2, sizeof(buf2) - 1, "$%s*%02X\r\n", buf1,
-                gpsutils_checksum(buf1, -1));
-        rc = gpsdevice_send_message(fd, buf2);
-    } while (0);
-    return rc;
+        if (keep == len || (keep == 0 && len == sizeof(buf))) {
+            len = 0;
+        } else {
+            memmove(buf, buf + keep, len - keep);
+            len -= keep;
+        }
+    }
+}
+
+int gpsdevice_negotiate_baudrate(int fd, uint32_t current_baud,
+            uint32_t baud_rate, uint32_t timeout_ms)
+{
+    speed_t current_speed, new_speed;
+    if (fd < 0 || gpsdevice_internal_baudspeed(current_baud, &current_speed) < 0 ||
+        gpsdevice_internal_baudspeed(baud_rate, &new_speed) < 0) {
+        GPSUTILS_ERROR("Invalid baud rates %u and %u bps\n", current_baud, baud_rate);
+        return -1;
+    }
+    if (timeout_ms == 0)
+        timeout_ms = GPSDEVICE_NEGOTIATE_TIMEOUT_MS;
+    // tell the chip at the rate it listens on and let it finish sending.
+    // the output is drained before every switch, so only the input is dropped
+    if (gpsdevice_internal_set_speed(fd, current_speed, TCIFLUSH) < 0 ||
+        gpsdevice_internal_send_baudrate(fd, baud_rate) < 0 || tcdrain(fd) < 0) {
+        GPSUTILS_ERROR("Unable to send the baud rate %u bps at %u bps\n",
+                baud_rate, current_baud);
+        return -1;
+    }
+    if (current_baud == baud_rate)
+        return (int)current_baud;
+    if (gpsdevice_internal_set_speed(fd, new_speed, TCIFLUSH) == 0) {
+        int vrc = gpsdevice_internal_verify_link(fd, timeout_ms);
+        if (vrc > 0) {
+            GPSUTILS_INFO("Baud rate changed from %u to %u bps on fd %d\n",
+                    current_baud, baud_rate, fd);
+            return (int)baud_rate;
+        }
+        GPSUTILS_WARN("No valid messages at %u bps on fd %d, falling back to %u bps\n",
+                baud_rate, fd, current_baud);
+        // in case the chip did switch but its messages were not understood
+        if (gpsdevice_internal_send_baudrate(fd, current_baud) == 0)
+            tcdrain(fd);
+    }
+    if (gpsdevice_internal_set_speed(fd, current_speed, TCIFLUSH) < 0 ||
+        gpsdevice_internal_verify_link(fd, timeout_ms) <= 0) {
+        GPSUTILS_ERROR("Lost the link on fd %d at %u and %u bps\n", fd,
+                baud_rate, current_baud);
+        return -1;
+    }
+    return (int)current_baud;
 }
 
 int gpsdevice_set_standby(int fd)
@@ -469,6 +842,63 @@ int gpsdevice_set_fix_interval(int fd, uint16_t milliseconds)
     return gpsdevice_send_message(fd, buf2);
 }
 
+/* the longest sentences the chip sends per fix. GPGSV sends up to 3 messages
+ * every 5 fixes */
+#define GPSDEVICE_BYTES_GPRMC 72
+#define GPSDEVICE_BYTES_GPGGA 74
+#define GPSDEVICE_BYTES_GPVTG 38
+#define GPSDEVICE_BYTES_GPGSA 66
+#define GPSDEVICE_BYTES_GPGSV ((3 * 70) / 5)
+// the share of the link the sentences may take
+#define GPSDEVICE_LINK_USAGE_PERCENT 80
+
+uint16_t gpsdevice_min_fix_interval(uint32_t baud_rate, bool is_gpvtg,
+            bool is_gpgsa, bool is_gpgsv)
+{
+    speed_t baudspeed;
+    if (gpsdevice_internal_baudspeed(baud_rate, &baudspeed) < 0)
+        return 0;
+    uint64_t bytes = GPSDEVICE_BYTES_GPRMC + GPSDEVICE_BYTES_GPGGA;
+    if (is_gpvtg)
+        bytes += GPSDEVICE_BYTES_GPVTG;
+    if (is_gpgsa)
+        bytes += GPSDEVICE_BYTES_GPGSA;
+    if (is_gpgsv)
+        bytes += GPSDEVICE_BYTES_GPGSV;
+    // 10 bits per byte with 8N1 framing
+    uint64_t usable = (uint64_t)baud_rate * GPSDEVICE_LINK_USAGE_PERCENT / 100;
+    uint64_t ms = (bytes * 10 * 1000 + usable - 1) / usable;
+    ms = ((ms + 99) / 100) * 100;
+    if (ms < 100)
+        ms = 100;
+    if (ms > 10000)
+        ms = 10000;
+    return (uint16_t)ms;
+}
+
+int gpsdevice_set_fix_interval_safe(int fd, uint32_t baud_rate,
+            uint16_t milliseconds, bool is_gpvtg, bool is_gpgsa, bool is_gpgsv)
+{
+    uint16_t min_ms = gpsdevice_min_fix_interval(baud_rate, is_gpvtg, is_gpgsa,
+                        is_gpgsv);
+    if (fd < 0 || min_ms == 0) {
+        GPSUTILS_ERROR("Invalid fd %d or baud rate %u bps\n", fd, baud_rate);
+        return -1;
+    }
+    if (milliseconds < min_ms) {
+        GPSUTILS_WARN("A fix interval of %u ms is too short for %u bps, using %u ms\n",
+                milliseconds, baud_rate, min_ms);
+        milliseconds = min_ms;
+    }
+    if (milliseconds > 10000)
+        milliseconds = 10000;
+    // the sentences are set first so the faster rate never overruns the link
+    if (gpsdevice_set_enabled(fd, is_gpvtg, is_gpgsa, is_gpgsv) < 0 ||
+        gpsdevice_set_fix_interval(fd, milliseconds) < 0)
+        return -1;
+    return milliseconds;
+}
+
 int gpsdevice_set_enabled(int fd, bool is_gpvtg, bool is_gpgsa, bool is_gpgsv)
 {
     char buf1[64];
@@ -0,0 +1,324 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+
+/** NOTE: the sentences of one fix are formatted into an epoch buffer and
+ * copied out of it by gpsdata_generator_fill(), so a caller can use any
+ * buffer size and the stream is the same irrespective of it **/
+
+// room for every sentence of a fix, the largest being 3 GPGSV messages
+#define GPSDATA_GENERATOR_EPOCH_MAX 1024
+#define GPSDATA_GENERATOR_SENTENCE_MAX 128
+#define GPSDATA_GENERATOR_SATS 12
+#define GPSDATA_GENERATOR_EARTH_RADIUS 6371000.0
+#define GPSDATA_GENERATOR_MPS_TO_KNOTS 1.943844
+
+typedef struct {
+    uint8_t id;
+    float elevation;
+    float azimuth;
+    uint8_t snr;
+} gpsdata_generator_sat_t;
+
+struct gpsdata_generator_t {
+    gpsdata_generator_config_t config;
+    gpsdata_generator_stats_t stats;
+    uint64_t rng;
+    double latitude;
+    double longitude;
+    double altitude;
+    double speed;
+    double course;
+    int64_t time_usec;
+    float hdop;
+    uint8_t num_used;
+    gpsdata_generator_sat_t sats[GPSDATA_GENERATOR_SATS];
+    char epoch[GPSDATA_GENERATOR_EPOCH_MAX];
+    size_t epoch_len;
+    size_t epoch_off;
+};
+
+void gpsdata_generator_config_default(gpsdata_generator_config_t *config)
+{
+    if (config) {
+        memset(config, 0, sizeof(*config));
+        config->seed = 3339;
+        config->fix_interval_ms = 1000;
+        config->msgid_mask = GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGGA) |
+                             GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPRMC) |
+                             GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPVTG) |
+                             GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGSA);
+        config->gsv_every = 5;
+        config->pgtop_every = 10;
+        config->pmtk_every = 0;
+        config->start_latitude = 40.809988;
+        config->start_longitude = -74.309027;
+        config->altitude_meters = 107.2f;
+        config->speed_mps = 5.0f;
+        // 9th April 2020 20:56:22 UTC, like the sample files
+        config->start_usec = INT64_C(1586465782) * 1000000;
+    }
+}
+
+// xorshift64*, which is plenty for test data and the same everywhere
+static uint64_t gpsdata_generator_next(gpsdata_generator_t *gen)
+{
+    gen->rng ^= gen->rng >> 12;
+    gen->rng ^= gen->rng << 25;
+    gen->rng ^= gen->rng >> 27;
+    return gen->rng * UINT64_C(2685821657736338717);
+}
+
+// uniform in [0, 1)
+static double gpsdata_generator_uniform(gpsdata_generator_t *gen)
+{
+    return (double)(gpsdata_generator_next(gen) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// uniform in [-range, range)
+static double gpsdata_generator_jitter(gpsdata_generator_t *gen, double range)
+{
+    return (gpsdata_generator_uniform(gen) * 2.0 - 1.0) * range;
+}
+
+gpsdata_generator_t *gpsdata_generator_create(const gpsdata_generator_config_t *config)
+{
+    if (!config || config->fix_interval_ms == 0 ||
+        fabs(config->start_latitude) >= 89.0 ||
+        fabs(config->start_longitude) > 180.0 || config->speed_mps < 0.0f) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return NULL;
+    }
+    gpsdata_generator_t *gen = calloc(1, sizeof(*gen));
+    if (!gen) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*gen));
+        return NULL;
+    }
+    gen->config = *config;
+    // xorshift must not start at 0
+    gen->rng = config->seed ? config->seed : UINT64_C(0x9E3779B97F4A7C15);
+    gen->latitude = config->start_latitude;
+    gen->longitude = config->start_longitude;
+    gen->altitude = config->altitude_meters;
+    gen->speed = config->speed_mps;
+    gen->course = gpsdata_generator_uniform(gen) * 360.0;
+    gen->time_usec = config->start_usec;
+    gen->hdop = 0.95f;
+    gen->num_used = 8;
+    for (size_t i = 0; i < GPSDATA_GENERATOR_SATS; ++i) {
+        gen->sats[i].id = (uint8_t)(1 + (i * 32) / GPSDATA_GENERATOR_SATS);
+        gen->sats[i].elevation = (float)(5.0 + gpsdata_generator_uniform(gen) * 80.0);
+        gen->sats[i].azimuth = (float)(gpsdata_generator_uniform(gen) * 360.0);
+        gen->sats[i].snr = (uint8_t)(15 + gpsdata_generator_next(gen) % 35);
+    }
+    return gen;
+}
+
+void gpsdata_generator_free(gpsdata_generator_t *gen)
+{
+    if (gen)
+        GPSUTILS_FREE(gen);
+}
+
+int gpsdata_generator_get_stats(const gpsdata_generator_t *gen,
+            gpsdata_generator_stats_t *stats)
+{
+    if (!gen || !stats)
+        return -1;
+    *stats = gen->stats;
+    return 0;
+}
+
+// wraps the body in '$' and "*hh\r\n" and injects the configured errors
+static void gpsdata_generator_emit(gpsdata_generator_t *gen, const char *body, int blen)
+{
+    if (blen <= 0 || blen > GPSDATA_GENERATOR_SENTENCE_MAX - 6)
+        return;
+    char msg[GPSDATA_GENERATOR_SENTENCE_MAX];
+    uint8_t cksum = gpsutils_xor_bytes(body, (size_t)blen);
+    if (gen->config.bad_checksum_rate > 0 &&
+        gpsdata_generator_uniform(gen) < gen->config.bad_checksum_rate) {
+        cksum ^= (uint8_t)(1 + gpsdata_generator_next(gen) % 255);
+        gen->stats.bad_checksums++;
+    }
+    int len = snprintf(msg, sizeof(msg), "$%.*s*%02X\r\n", blen, body, cksum);
+    if (len <= 0 || (size_t)len >= sizeof(msg))
+        return;
+    if (gen->config.bitflip_rate > 0 &&
+        gpsdata_generator_uniform(gen) < gen->config.bitflip_rate) {
+        // anywhere after the '$' so the parser still sees the sentence start
+        size_t pos = 1 + gpsdata_generator_next(gen) % (size_t)(len - 1);
+        msg[pos] ^= (char)(1 << (gpsdata_generator_next(gen) % 7));
+        gen->stats.bitflips++;
+    }
+    if (gen->config.truncate_rate > 0 &&
+        gpsdata_generator_uniform(gen) < gen->config.truncate_rate) {
+        len = 1 + (int)(gpsdata_generator_next(gen) % (uint64_t)(len - 1));
+        gen->stats.truncations++;
+    }
+    if (gen->epoch_len + (size_t)len <= sizeof(gen->epoch)) {
+        memcpy(gen->epoch + gen->epoch_len, msg, (size_t)len);
+        gen->epoch_len += (size_t)len;
+        gen->stats.sentences++;
+    }
+}
+
+// ddmm.mmmm or dddmm.mmmm followed by the hemisphere
+static int gpsdata_generator_coord(char *buf, size_t len, double value,
+            int degree_digits, char pos, char neg)
+{
+    // in 1/10000ths of a minute so the minutes never round up to 60
+    int64_t total = llround(fabs(value) * 600000.0);
+    int64_t deg = total / 600000;
+    int64_t minutes = total % 600000;
+    return snprintf(buf, len, "%0*" PRId64 "%02" PRId64 ".%04" PRId64 ",%c",
+            degree_digits, deg, minutes / 10000, minutes % 10000,
+            (value < 0) ? neg : pos);
+}
+
+static void gpsdata_generator_move(gpsdata_generator_t *gen)
+{
+    double dt = gen->config.fix_interval_ms / 1000.0;
+    double mean = gen->config.speed_mps;
+    if (mean > 0) {
+        // wander around the mean speed and turn a little every fix
+        gen->speed += gpsdata_generator_jitter(gen, 0.1 * mean) + 0.05 * (mean - gen->speed);
+        if (gen->speed < 0)
+            gen->speed = 0;
+        gen->course = fmod(gen->course + gpsdata_generator_jitter(gen, 5.0) + 360.0, 360.0);
+        double dist = gen->speed * dt;
+        double crs = gen->course * M_PI / 180.0;
+        double lat = gen->latitude * M_PI / 180.0;
+        gen->latitude += (dist * cos(crs) / GPSDATA_GENERATOR_EARTH_RADIUS) * 180.0 / M_PI;
+        gen->longitude += (dist * sin(crs) / (GPSDATA_GENERATOR_EARTH_RADIUS * cos(lat))) *
+                            180.0 / M_PI;
+        // keep away from the poles and wrap around the antimeridian
+        if (gen->latitude > 85.0 || gen->latitude < -85.0) {
+            gen->latitude = (gen->latitude > 0) ? 85.0 : -85.0;
+            gen->course = fmod(540.0 - gen->course, 360.0);
+        }
+        if (gen->longitude > 180.0)
+            gen->longitude -= 360.0;
+        else if (gen->longitude < -180.0)
+            gen->longitude += 360.0;
+    }
+    gen->altitude += gpsdata_generator_jitter(gen, 0.5);
+    gen->hdop = (float)(0.8 + gpsdata_generator_uniform(gen) * 0.6);
+    gen->num_used = (uint8_t)(6 + gpsdata_generator_next(gen) % 5);
+    for (size_t i = 0; i < GPSDATA_GENERATOR_SATS; ++i) {
+        gpsdata_generator_sat_t *sat = &(gen->sats[i]);
+        sat->azimuth = (float)fmod(sat->azimuth + 0.01 * dt + 360.0, 360.0);
+        int snr = (int)sat->snr + (int)(gpsdata_generator_next(gen) % 3) - 1;
+        sat->snr = (uint8_t)((snr < 10) ? 10 : (snr > 50) ? 50 : snr);
+    }
+}
+
+static void gpsdata_generator_epoch(gpsdata_generator_t *gen)
+{
+    const gpsdata_generator_config_t *cfg = &(gen->config);
+    char body[GPSDATA_GENERATOR_SENTENCE_MAX];
+    char lat[32], lon[32], utc[32], date[32];
+    int n;
+    gen->epoch_len = 0;
+    gen->epoch_off = 0;
+    time_t secs = (time_t)(gen->time_usec / 1000000);
+    struct tm tm1;
+    memset(&tm1, 0, sizeof(tm1));
+    gmtime_r(&secs, &tm1);
+    snprintf(utc, sizeof(utc), "%02d%02d%02d.%03d", tm1.tm_hour, tm1.tm_min,
+            tm1.tm_sec, (int)((gen->time_usec / 1000) % 1000));
+    snprintf(date, sizeof(date), "%02d%02d%02d", tm1.tm_mday, tm1.tm_mon + 1,
+            tm1.tm_year % 100);
+    gpsdata_generator_coord(lat, sizeof(lat), gen->latitude, 2, 'N', 'S');
+    gpsdata_generator_coord(lon, sizeof(lon), gen->longitude, 3, 'E', 'W');
+    double knots = gen->speed * GPSDATA_GENERATOR_MPS_TO_KNOTS;
+    uint64_t fix = gen->stats.fixes;
+
+    if (cfg->msgid_mask & GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGGA)) {
+        n = snprintf(body, sizeof(body), "GPGGA,%s,%s,%s,1,%02u,%.2f,%.1f,M,-34.2,M,,",
+                utc, lat, lon, gen->num_used, gen->hdop, gen->altitude);
+        gpsdata_generator_emit(gen, body, n);
+    }
+    if (cfg->msgid_mask & GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGSA)) {
+        n = snprintf(body, sizeof(body), "GPGSA,A,3");
+        for (size_t i = 0; i < GPSDATA_GENERATOR_SATS && n > 0 &&
+                (size_t)n < sizeof(body); ++i) {
+            if (i < gen->num_used)
+                n += snprintf(body + n, sizeof(body) - n, ",%02u", gen->sats[i].id);
+            else
+                n += snprintf(body + n, sizeof(body) - n, ",");
+        }
+        if (n > 0 && (size_t)n < sizeof(body)) {
+            n += snprintf(body + n, sizeof(body) - n, ",%.2f,%.2f,%.2f",
+                    gen->hdop * 2.2f, gen->hdop, gen->hdop * 2.0f);
+            gpsdata_generator_emit(gen, body, n);
+        }
+    }
+    if (cfg->gsv_every > 0 && (fix % cfg->gsv_every) == 0) {
+        unsigned count = (GPSDATA_GENERATOR_SATS + 3) / 4;
+        for (unsigned m = 0; m < count; ++m) {
+            n = snprintf(body, sizeof(body), "GPGSV,%u,%u,%02u", count, m + 1,
+                    GPSDATA_GENERATOR_SATS);
+            for (unsigned i = m * 4; i < (m + 1) * 4 && i < GPSDATA_GENERATOR_SATS &&
+                    n > 0 && (size_t)n < sizeof(body); ++i) {
+                const gpsdata_generator_sat_t *sat = &(gen->sats[i]);
+                n += snprintf(body + n, sizeof(body) - n, ",%02u,%02d,%03d,%02u",
+                        sat->id, (int)sat->elevation, (int)sat->azimuth % 360,
+                        sat->snr);
+            }
+            gpsdata_generator_emit(gen, body, n);
+        }
+    }
+    if (cfg->msgid_mask & GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPRMC)) {
+        n = snprintf(body, sizeof(body), "GPRMC,%s,A,%s,%s,%.2f,%.2f,%s,,,A",
+                utc, lat, lon, knots, gen->course, date);
+        gpsdata_generator_emit(gen, body, n);
+    }
+    if (cfg->msgid_mask & GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGLL)) {
+        n = snprintf(body, sizeof(body), "GPGLL,%s,%s,%s,A,A", lat, lon, utc);
+        gpsdata_generator_emit(gen, body, n);
+    }
+    if (cfg->msgid_mask & GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPVTG)) {
+        n = snprintf(body, sizeof(body), "GPVTG,%.2f,T,,M,%.2f,N,%.2f,K,A",
+                gen->course, knots, gen->speed * 3.6);
+        gpsdata_generator_emit(gen, body, n);
+    }
+    if (cfg->pgtop_every > 0 && (fix % cfg->pgtop_every) == 0) {
+        n = snprintf(body, sizeof(body), "PGTOP,11,3");
+        gpsdata_generator_emit(gen, body, n);
+    }
+    if (cfg->pmtk_every > 0 && (fix % cfg->pmtk_every) == 0) {
+        n = snprintf(body, sizeof(body), "PMTK705,AXN_2.31_3339_13101700,5632,PA6H,1.0");
+        gpsdata_generator_emit(gen, body, n);
+    }
+    gen->stats.fixes++;
+    gen->time_usec += (int64_t)cfg->fix_interval_ms * 1000;
+    gpsdata_generator_move(gen);
+}
+
+ssize_t gpsdata_generator_fill(gpsdata_generator_t *gen, char *buf, size_t buflen)
+{
+    if (!gen || !buf || buflen > SSIZE_MAX) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return -1;
+    }
+    size_t off = 0;
+    while (off < buflen) {
+        if (gen->epoch_off >= gen->epoch_len) {
+            gpsdata_generator_epoch(gen);
+            if (gen->epoch_len == 0)
+                break; // nothing is enabled
+        }
+        size_t n = gen->epoch_len - gen->epoch_off;
+        if (n > buflen - off)
+            n = buflen - off;
+        memcpy(buf + off, gen->epoch + gen->epoch_off, n);
+        gen->epoch_off += n;
+        off += n;
+    }
+    gen->stats.bytes += off;
+    return (ssize_t)off;
+}
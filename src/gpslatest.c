@@ -0,0 +1,154 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+#include <stdatomic.h>
+
+/** NOTE: this is a sequence lock. The writer makes the sequence odd, stores
+ * the snapshot and makes it even again. A reader retries if the sequence was
+ * odd or changed while it copied. The snapshot is stored as relaxed atomic
+ * words so that a read overlapping a write is not a data race **/
+
+#define GPSDATA_LATEST_WORDS \
+    ((sizeof(gpsdata_latest_snapshot_t) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+
+typedef union {
+    gpsdata_latest_snapshot_t snap;
+    uint64_t words[GPSDATA_LATEST_WORDS];
+} gpsdata_latest_buf_t;
+
+struct gpsdata_latest_t {
+    atomic_uint_fast64_t seq;
+    _Atomic uint64_t words[GPSDATA_LATEST_WORDS];
+    // the writer's own copy, merged into before publishing
+    gpsdata_latest_buf_t cur;
+};
+
+gpsdata_latest_t *gpsdata_latest_create(void)
+{
+    gpsdata_latest_t *lt = calloc(1, sizeof(*lt));
+    if (!lt) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*lt));
+        return NULL;
+    }
+    lt->cur.snap.latitude_e7 = GPSDATA_FIXED_UNSET;
+    lt->cur.snap.longitude_e7 = GPSDATA_FIXED_UNSET;
+    lt->cur.snap.altitude_mm = GPSDATA_FIXED_UNSET;
+    lt->cur.snap.speed_mmps = GPSDATA_FIXED_UNSET;
+    lt->cur.snap.course_degrees = NAN;
+    lt->cur.snap.dop.pdop = NAN;
+    lt->cur.snap.dop.hdop = NAN;
+    lt->cur.snap.dop.vdop = NAN;
+    atomic_init(&(lt->seq), 0);
+    for (size_t i = 0; i < GPSDATA_LATEST_WORDS; ++i)
+        atomic_init(&(lt->words[i]), lt->cur.words[i]);
+    return lt;
+}
+
+void gpsdata_latest_free(gpsdata_latest_t *lt)
+{
+    GPSUTILS_FREE(lt);
+}
+
+static void gpsdata_latest_copy_string(char *dst, const char *src)
+{
+    if (src) {
+        strncpy(dst, src, GPSDATA_LATEST_FW_LEN - 1);
+        dst[GPSDATA_LATEST_FW_LEN - 1] = '\0';
+    } else {
+        dst[0] = '\0';
+    }
+}
+
+void gpsdata_latest_update(gpsdata_latest_t *lt, const gpsdata_data_t *item)
+{
+    if (!lt || !item)
+        return;
+    gpsdata_latest_snapshot_t *snap = &(lt->cur.snap);
+    uint64_t now = gpsutils_monotonic_ms();
+    bool changed = false;
+    if (item->latitude_e7 != GPSDATA_FIXED_UNSET &&
+        item->longitude_e7 != GPSDATA_FIXED_UNSET) {
+        snap->position_rx_ms = now;
+        snap->latitude_e7 = item->latitude_e7;
+        snap->longitude_e7 = item->longitude_e7;
+        snap->timestamp_usec = item->is_valid_timestamp ?
+            ((int64_t)item->timestamp.tv_sec * 1000000 + item->timestamp.tv_usec) : 0;
+        if (item->msgid == GPSDATA_MSGID_GPGGA ||
+            (item->fused_msgids & GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGGA))) {
+            snap->posfix = (uint8_t)item->posfix;
+            snap->num_satellites = (item->num_satellites > UINT8_MAX) ?
+                    UINT8_MAX : (uint8_t)item->num_satellites;
+        }
+        if (item->mode != GPSDATA_MODE_UNSET)
+            snap->mode = (uint8_t)item->mode;
+        changed = true;
+    }
+    if (item->altitude_mm != GPSDATA_FIXED_UNSET) {
+        snap->altitude_rx_ms = now;
+        snap->altitude_mm = item->altitude_mm;
+        changed = true;
+    }
+    if (item->speed_mmps != GPSDATA_FIXED_UNSET || !isnan(item->course_degrees)) {
+        snap->velocity_rx_ms = now;
+        snap->speed_mmps = item->speed_mmps;
+        snap->course_degrees = item->course_degrees;
+        changed = true;
+    }
+    if (!isnan(item->dop.pdop) || !isnan(item->dop.hdop) || !isnan(item->dop.vdop)) {
+        snap->dop_rx_ms = now;
+        if (!isnan(item->dop.pdop))
+            snap->dop.pdop = item->dop.pdop;
+        if (!isnan(item->dop.hdop))
+            snap->dop.hdop = item->dop.hdop;
+        if (!isnan(item->dop.vdop))
+            snap->dop.vdop = item->dop.vdop;
+        changed = true;
+    }
+    if (item->antenna_status != GPSDATA_ANTENNA_UNSET) {
+        snap->antenna_rx_ms = now;
+        snap->antenna_status = (uint8_t)item->antenna_status;
+        changed = true;
+    }
+    if (item->fwinfo.firmware) {
+        snap->firmware_rx_ms = now;
+        gpsdata_latest_copy_string(snap->firmware, item->fwinfo.firmware);
+        gpsdata_latest_copy_string(snap->build_id, item->fwinfo.build_id);
+        gpsdata_latest_copy_string(snap->chip_name, item->fwinfo.chip_name);
+        gpsdata_latest_copy_string(snap->chip_version, item->fwinfo.chip_version);
+        changed = true;
+    }
+    if (!changed)
+        return;
+    snap->seq++;
+    uint_fast64_t seq = atomic_load_explicit(&(lt->seq), memory_order_relaxed);
+    atomic_store_explicit(&(lt->seq), seq + 1, memory_order_relaxed);
+    // the odd sequence must be visible before any of the words change
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < GPSDATA_LATEST_WORDS; ++i) {
+        atomic_store_explicit(&(lt->words[i]), lt->cur.words[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&(lt->seq), seq + 2, memory_order_release);
+}
+
+int gpsdata_latest_read(const gpsdata_latest_t *lt, gpsdata_latest_snapshot_t *out)
+{
+    if (!lt || !out)
+        return -1;
+    gpsdata_latest_buf_t buf;
+    while (1) {
+        uint_fast64_t seq = atomic_load_explicit(&(lt->seq), memory_order_acquire);
+        if (seq & 1)
+            continue; // an update is in progress
+        for (size_t i = 0; i < GPSDATA_LATEST_WORDS; ++i) {
+            buf.words[i] = atomic_load_explicit(&(lt->words[i]), memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&(lt->seq), memory_order_relaxed) == seq)
+            break;
+    }
+    memcpy(out, &(buf.snap), sizeof(*out));
+    return 0;
+}
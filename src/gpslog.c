@@ -0,0 +1,277 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsconfig.h>
+#include <gpsutils.h>
+#ifdef LIBGPS_MTK3339_HAVE_PTHREAD_H
+    #include <pthread.h>
+#endif
+#include <stdatomic.h>
+
+/** NOTE: the ring is a bounded multi-producer single-consumer queue. Each slot
+ * carries a sequence number that tells producers and the drain thread whose
+ * turn it is, so neither side ever takes a lock **/
+
+#define GPSUTILS_LOGRING_MSG_MAX 256
+// the drain thread sleeps this long when the ring is empty
+#define GPSUTILS_LOGRING_IDLE_NSEC 1000000L
+
+typedef struct {
+    atomic_size_t seq;
+    uint16_t len;
+    char msg[GPSUTILS_LOGRING_MSG_MAX];
+} gpsutils_logring_slot_t;
+
+struct gpsutils_logring_t {
+    gpsutils_logsink_t sink;
+    FILE *fp;
+    gpsutils_logring_slot_t *slots;
+    size_t mask;
+    pthread_t thread;
+    atomic_bool stop;
+    atomic_uint_fast64_t dropped;
+    // producers and the drain thread write these, keep them on separate
+    // cache lines
+    char _pad0[64];
+    atomic_size_t head;
+    char _pad1[64];
+    size_t tail;
+};
+
+static void gpsutils_logring_write(void *ctx, int level, const char *fmt,
+                const char *msg, size_t len)
+{
+    gpsutils_logring_t *ring = (gpsutils_logring_t *)ctx;
+    (void)level;
+    (void)fmt;
+    size_t pos = atomic_load_explicit(&(ring->head), memory_order_relaxed);
+    while (1) {
+        gpsutils_logring_slot_t *slot = &(ring->slots[pos & ring->mask]);
+        size_t seq = atomic_load_explicit(&(slot->seq), memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&(ring->head), &pos, pos + 1,
+                        memory_order_relaxed, memory_order_relaxed)) {
+                if (len > GPSUTILS_LOGRING_MSG_MAX)
+                    len = GPSUTILS_LOGRING_MSG_MAX;
+                memcpy(slot->msg, msg, len);
+                slot->len = (uint16_t)len;
+                atomic_store_explicit(&(slot->seq), pos + 1, memory_order_release);
+                return;
+            }
+            // pos was reloaded by the failed exchange
+        } else if (diff < 0) {
+            // the drain thread has not caught up
+            atomic_fetch_add_explicit(&(ring->dropped), 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&(ring->head), memory_order_relaxed);
+        }
+    }
+}
+
+static size_t gpsutils_logring_drain(gpsutils_logring_t *ring)
+{
+    size_t count = 0;
+    while (1) {
+        gpsutils_logring_slot_t *slot = &(ring->slots[ring->tail & ring->mask]);
+        size_t seq = atomic_load_explicit(&(slot->seq), memory_order_acquire);
+        if (seq != ring->tail + 1)
+            break;
+        fwrite(slot->msg, 1, slot->len, ring->fp);
+        atomic_store_explicit(&(slot->seq), ring->tail + ring->mask + 1,
+                memory_order_release);
+        ring->tail++;
+        count++;
+    }
+    if (count > 0)
+        fflush(ring->fp);
+    return count;
+}
+
+static void *gpsutils_logring_thread(void *arg)
+{
+    gpsutils_logring_t *ring = (gpsutils_logring_t *)arg;
+    while (!atomic_load_explicit(&(ring->stop), memory_order_acquire)) {
+        if (gpsutils_logring_drain(ring) == 0) {
+            struct timespec ts = { 0, GPSUTILS_LOGRING_IDLE_NSEC };
+            nanosleep(&ts, NULL);
+        }
+    }
+    gpsutils_logring_drain(ring);
+    return NULL;
+}
+
+gpsutils_logring_t *gpsutils_logring_create(size_t capacity, FILE *fp)
+{
+    if (!fp || capacity == 0 || capacity > (SIZE_MAX >> 2)) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return NULL;
+    }
+    size_t cap = 2;
+    while (cap < capacity)
+        cap <<= 1;
+    gpsutils_logring_t *ring = calloc(1, sizeof(*ring));
+    if (!ring) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*ring));
+        return NULL;
+    }
+    ring->slots = calloc(cap, sizeof(*(ring->slots)));
+    if (!ring->slots) {
+        GPSUTILS_ERROR_NOMEM(cap * sizeof(*(ring->slots)));
+        GPSUTILS_FREE(ring);
+        return NULL;
+    }
+    for (size_t i = 0; i < cap; ++i)
+        atomic_init(&(ring->slots[i].seq), i);
+    ring->mask = cap - 1;
+    ring->fp = fp;
+    ring->tail = 0;
+    atomic_init(&(ring->head), 0);
+    atomic_init(&(ring->stop), false);
+    atomic_init(&(ring->dropped), 0);
+    ring->sink.write = gpsutils_logring_write;
+    ring->sink.ctx = ring;
+    int err = pthread_create(&(ring->thread), NULL, gpsutils_logring_thread, ring);
+    if (err != 0) {
+        GPSUTILS_ERROR("Failed to start the log thread: %s(%d)\n", strerror(err), err);
+        GPSUTILS_FREE(ring->slots);
+        GPSUTILS_FREE(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+void gpsutils_logring_free(gpsutils_logring_t *ring)
+{
+    if (ring) {
+        atomic_store_explicit(&(ring->stop), true, memory_order_release);
+        pthread_join(ring->thread, NULL);
+        GPSUTILS_FREE(ring->slots);
+        GPSUTILS_FREE(ring);
+    }
+}
+
+const gpsutils_logsink_t *gpsutils_logring_sink(gpsutils_logring_t *ring)
+{
+    return ring ? &(ring->sink) : NULL;
+}
+
+uint64_t gpsutils_logring_dropped(const gpsutils_logring_t *ring)
+{
+    return ring ? atomic_load_explicit(&(ring->dropped), memory_order_relaxed) : 0;
+}
+
+// number of call sites tracked. others are forwarded without limits
+#define GPSUTILS_LOGRATE_SITES 64
+
+typedef struct {
+    const char *fmt;
+    uint64_t window_start_ms;
+    uint32_t count;
+    uint32_t suppressed;
+} gpsutils_lograte_site_t;
+
+struct gpsutils_lograte_t {
+    gpsutils_logsink_t sink;
+    const gpsutils_logsink_t *next;
+    uint32_t burst;
+    uint32_t interval_ms;
+    gpsutils_lograte_site_t sites[GPSUTILS_LOGRATE_SITES];
+};
+
+static void gpsutils_lograte_forward(gpsutils_lograte_t *rl, int level,
+                const char *fmt, const char *msg, size_t len)
+{
+    if (rl->next && rl->next->write)
+        rl->next->write(rl->next->ctx, level, fmt, msg, len);
+    else
+        fwrite(msg, 1, len, GPSUTILS_LOG_PTR);
+}
+
+static void gpsutils_lograte_report(gpsutils_lograte_t *rl,
+                gpsutils_lograte_site_t *site)
+{
+    char buf[128];
+    int n = snprintf(buf, sizeof(buf),
+            "WARN: suppressed %" PRIu32 " repeats of a log message in %" PRIu32 "ms\n",
+            site->suppressed, rl->interval_ms);
+    if (n > 0) {
+        gpsutils_lograte_forward(rl, GPSUTILS_LOGLEVEL_WARN, site->fmt, buf,
+                ((size_t)n < sizeof(buf)) ? (size_t)n : sizeof(buf) - 1);
+    }
+    site->suppressed = 0;
+}
+
+static void gpsutils_lograte_write(void *ctx, int level, const char *fmt,
+                const char *msg, size_t len)
+{
+    gpsutils_lograte_t *rl = (gpsutils_lograte_t *)ctx;
+    // format strings are literals so the pointer identifies the call site
+    size_t idx = ((uintptr_t)fmt >> 3) % GPSUTILS_LOGRATE_SITES;
+    gpsutils_lograte_site_t *site = NULL;
+    for (size_t i = 0; i < GPSUTILS_LOGRATE_SITES; ++i) {
+        gpsutils_lograte_site_t *s = &(rl->sites[(idx + i) % GPSUTILS_LOGRATE_SITES]);
+        if (s->fmt == fmt || !s->fmt) {
+            site = s;
+            break;
+        }
+    }
+    if (!site) {
+        gpsutils_lograte_forward(rl, level, fmt, msg, len);
+        return;
+    }
+    uint64_t now = gpsutils_monotonic_ms();
+    if (!site->fmt || now - site->window_start_ms >= rl->interval_ms) {
+        if (site->suppressed > 0)
+            gpsutils_lograte_report(rl, site);
+        site->fmt = fmt;
+        site->window_start_ms = now;
+        site->count = 0;
+    }
+    if (site->count < rl->burst) {
+        site->count++;
+        gpsutils_lograte_forward(rl, level, fmt, msg, len);
+    } else {
+        site->suppressed++;
+    }
+}
+
+gpsutils_lograte_t *gpsutils_lograte_create(const gpsutils_logsink_t *next,
+            uint32_t burst, uint32_t interval_ms)
+{
+    if (burst == 0) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return NULL;
+    }
+    gpsutils_lograte_t *rl = calloc(1, sizeof(*rl));
+    if (!rl) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*rl));
+        return NULL;
+    }
+    rl->next = next;
+    rl->burst = burst;
+    rl->interval_ms = interval_ms;
+    rl->sink.write = gpsutils_lograte_write;
+    rl->sink.ctx = rl;
+    return rl;
+}
+
+void gpsutils_lograte_free(gpsutils_lograte_t *rl)
+{
+    if (rl) {
+        // report what was held back in the last window
+        for (size_t i = 0; i < GPSUTILS_LOGRATE_SITES; ++i) {
+            if (rl->sites[i].fmt && rl->sites[i].suppressed > 0)
+                gpsutils_lograte_report(rl, &(rl->sites[i]));
+        }
+        GPSUTILS_FREE(rl);
+    }
+}
+
+const gpsutils_logsink_t *gpsutils_lograte_sink(gpsutils_lograte_t *rl)
+{
+    return rl ? &(rl->sink) : NULL;
+}
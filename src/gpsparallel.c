@@ -0,0 +1,305 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+#ifdef LIBGPS_MTK3339_HAVE_ERRNO_H
+    #include <errno.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_FCNTL_H
+    #include <fcntl.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_SYS_STAT_H
+    #include <sys/stat.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_SYS_MMAN_H
+    #include <sys/mman.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_PTHREAD_H
+    #include <pthread.h>
+#endif
+#include <stdatomic.h>
+
+/** NOTE: the parallel decoder splits a buffer into chunks at message
+ * boundaries and runs an independent parser on each chunk **/
+
+// chunks smaller than this are not worth a thread
+#define GPSDATA_PARALLEL_MIN_CHUNK 4096
+// more chunks than threads keeps the threads busy if chunks are uneven
+#define GPSDATA_PARALLEL_CHUNKS_PER_THREAD 4
+// each worker parser grows its item pool in slabs of this many items
+#define GPSDATA_PARALLEL_POOL_CAPACITY 1024
+
+typedef struct {
+    const char *buf;
+    size_t len;
+    // NULL for the default log output
+    const gpsutils_logsink_t *logsink;
+    gpsdata_list_t items;
+    // -1 on error or the number of messages the parser resynchronized after
+    int rc;
+} gpsdata_parallel_chunk_t;
+
+typedef struct {
+    gpsdata_parallel_chunk_t *chunks;
+    size_t num_chunks;
+    atomic_size_t next_chunk;
+} gpsdata_parallel_t;
+
+/* the chunks after the first have no GPRMC date until their own first GPRMC
+ * message, which gpsdata_parallel_fixup() makes up for, so their parsers do
+ * not warn about it once per chunk */
+static void gpsdata_parallel_logsink_write(void *ctx, int level, const char *fmt,
+                const char *msg, size_t len)
+{
+    (void)ctx;
+    if (level == GPSUTILS_LOGLEVEL_WARN && strstr(fmt, "RMC date is unavailable"))
+        return;
+    fwrite(msg, 1, len, GPSUTILS_LOG_PTR);
+}
+
+static const gpsutils_logsink_t gpsdata_parallel_logsink = {
+    gpsdata_parallel_logsink_write, NULL
+};
+
+static void gpsdata_parallel_parse_chunk(gpsdata_parallel_chunk_t *chunk)
+{
+    gpsdata_list_init(&(chunk->items));
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    if (!fsm) {
+        chunk->rc = -1;
+        return;
+    }
+    if (gpsdata_parser_set_pool_capacity(fsm, GPSDATA_PARALLEL_POOL_CAPACITY) < 0) {
+        GPSUTILS_WARN("Using the default item pool capacity for the chunk\n");
+    }
+    // a corrupt or truncated message must not lose the whole buffer
+    gpsdata_parser_set_resync(fsm, true);
+    gpsdata_parser_set_logsink(fsm, chunk->logsink);
+    chunk->rc = gpsdata_parser_parse_list(fsm, chunk->buf, chunk->len,
+                    &(chunk->items), NULL);
+    // the items outlive the parser and its pool is freed with the last item
+    gpsdata_parser_free(fsm);
+}
+
+static void *gpsdata_parallel_worker(void *arg)
+{
+    gpsdata_parallel_t *pp = (gpsdata_parallel_t *)arg;
+    while (1) {
+        size_t idx = atomic_fetch_add(&(pp->next_chunk), 1);
+        if (idx >= pp->num_chunks)
+            break;
+        gpsdata_parallel_parse_chunk(&(pp->chunks[idx]));
+    }
+    return NULL;
+}
+
+/* finds the start of the message at or after buf + off. messages start with a
+ * '$' right after a newline */
+static size_t gpsdata_parallel_next_boundary(const char *buf, size_t len, size_t off)
+{
+    while (off < len) {
+        const char *nl = memchr(buf + off, '\n', len - off);
+        if (!nl)
+            return len;
+        off = (size_t)(nl - buf) + 1;
+        if (off < len && buf[off] == '$')
+            return off;
+    }
+    return len;
+}
+
+static int64_t gpsdata_parallel_second_of_day(time_t secs)
+{
+    int64_t sod = (int64_t)secs % 86400;
+    return (sod < 0) ? sod + 86400 : sod;
+}
+
+/* a sequential parse carries the date of the last GPRMC message over to the
+ * GPGGA/GPGLL messages that follow it. a chunk parser has no such date until
+ * its own first GPRMC, so those messages get the date from the last GPRMC of
+ * the previous chunks here */
+static void gpsdata_parallel_fixup(gpsdata_parallel_chunk_t *chunks, size_t num_chunks)
+{
+    bool have_day = false;
+    int64_t day_epoch = 0;
+    for (size_t i = 0; i < num_chunks; ++i) {
+        bool seen_rmc = false;
+        gpsdata_data_t *item = NULL;
+        LL_FOREACH(chunks[i].items.head, item) {
+            if (item->msgid == GPSDATA_MSGID_GPRMC && item->is_valid_timestamp) {
+                seen_rmc = true;
+                have_day = true;
+                day_epoch = (int64_t)item->timestamp.tv_sec -
+                    gpsdata_parallel_second_of_day(item->timestamp.tv_sec);
+                continue;
+            }
+            if (seen_rmc || !have_day || item->is_valid_timestamp)
+                continue;
+            if ((item->msgid == GPSDATA_MSGID_GPGGA ||
+                 item->msgid == GPSDATA_MSGID_GPGLL) &&
+                (item->timestamp.tv_sec != 0 || item->timestamp.tv_usec != 0)) {
+                item->timestamp.tv_sec = (time_t)(day_epoch +
+                    gpsdata_parallel_second_of_day(item->timestamp.tv_sec));
+                item->is_valid_timestamp = true;
+            }
+        }
+    }
+}
+
+int gpsdata_parse_buffer_parallel(const char *buf, size_t len, size_t nthreads,
+            gpsdata_list_t *list, size_t *outnum)
+{
+    if (outnum)
+        *outnum = 0;
+    if (!buf || len == 0 || !list) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return -1;
+    }
+    if (nthreads == 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (ncpu > 0) ? (size_t)ncpu : 1;
+    }
+    size_t max_chunks = len / GPSDATA_PARALLEL_MIN_CHUNK;
+    size_t num_chunks = nthreads * GPSDATA_PARALLEL_CHUNKS_PER_THREAD;
+    if (num_chunks > max_chunks)
+        num_chunks = max_chunks;
+    if (num_chunks == 0)
+        num_chunks = 1;
+    if (nthreads > num_chunks)
+        nthreads = num_chunks;
+
+    gpsdata_parallel_chunk_t *chunks = calloc(num_chunks, sizeof(*chunks));
+    if (!chunks) {
+        GPSUTILS_ERROR_NOMEM(num_chunks * sizeof(*chunks));
+        return -1;
+    }
+    // split at message boundaries. a boundary search may run past the next
+    // nominal split point so some chunks may end up empty
+    size_t start = 0;
+    size_t used = 0;
+    for (size_t i = 0; i < num_chunks && start < len; ++i) {
+        size_t end = len;
+        if (i + 1 < num_chunks) {
+            size_t nominal = (len / num_chunks) * (i + 1);
+            end = gpsdata_parallel_next_boundary(buf, len,
+                        (nominal > start) ? nominal : start);
+        }
+        chunks[used].buf = buf + start;
+        chunks[used].len = end - start;
+        chunks[used].logsink = (used > 0) ? &gpsdata_parallel_logsink : NULL;
+        used++;
+        start = end;
+    }
+    num_chunks = used;
+    GPSUTILS_DEBUG("Parsing %zu bytes in %zu chunks using %zu threads\n",
+            len, num_chunks, nthreads);
+
+    gpsdata_parallel_t pp;
+    pp.chunks = chunks;
+    pp.num_chunks = num_chunks;
+    atomic_init(&(pp.next_chunk), 0);
+    int rc = 0;
+    size_t errors = 0;
+    if (nthreads <= 1) {
+        gpsdata_parallel_worker(&pp);
+    } else {
+        pthread_t *threads = calloc(nthreads, sizeof(*threads));
+        if (!threads) {
+            GPSUTILS_ERROR_NOMEM(nthreads * sizeof(*threads));
+            GPSUTILS_FREE(chunks);
+            return -1;
+        }
+        size_t started = 0;
+        for (; started < nthreads; ++started) {
+            int err = pthread_create(&threads[started], NULL,
+                            gpsdata_parallel_worker, &pp);
+            if (err != 0) {
+                // the threads that did start pick up the remaining chunks
+                GPSUTILS_WARN("Failed to start thread %zu: %s(%d)\n",
+                        started, strerror(err), err);
+                break;
+            }
+        }
+        if (started == 0) {
+            gpsdata_parallel_worker(&pp);
+        }
+        for (size_t i = 0; i < started; ++i) {
+            pthread_join(threads[i], NULL);
+        }
+        GPSUTILS_FREE(threads);
+    }
+    for (size_t i = 0; i < num_chunks; ++i) {
+        if (chunks[i].rc < 0) {
+            GPSUTILS_ERROR("Failed to parse chunk %zu at offset %zu\n", i,
+                    (size_t)(chunks[i].buf - buf));
+            rc = -1;
+        } else {
+            errors += (size_t)chunks[i].rc;
+        }
+    }
+    if (rc < 0) {
+        for (size_t i = 0; i < num_chunks; ++i) {
+            gpsdata_list_clear(&(chunks[i].items));
+        }
+    } else {
+        gpsdata_parallel_fixup(chunks, num_chunks);
+        size_t count = 0;
+        for (size_t i = 0; i < num_chunks; ++i) {
+            count += chunks[i].items.count;
+            gpsdata_list_concat(list, &(chunks[i].items));
+        }
+        if (outnum)
+            *outnum = count;
+        if (errors > 0) {
+            GPSUTILS_WARN("Skipped %zu corrupt or truncated messages\n", errors);
+        }
+        rc = (errors > INT_MAX) ? INT_MAX : (int)errors;
+    }
+    GPSUTILS_FREE(chunks);
+    return rc;
+}
+
+int gpsdata_parse_file_parallel(const char *path, size_t nthreads,
+            gpsdata_list_t *list, size_t *outnum)
+{
+    if (outnum)
+        *outnum = 0;
+    if (!path || !list) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return -1;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        int err = errno;
+        GPSUTILS_ERROR("Failed to open %s: %s(%d)\n", path, strerror(err), err);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int err = errno;
+        GPSUTILS_ERROR("Failed to stat %s: %s(%d)\n", path, strerror(err), err);
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        GPSUTILS_WARN("File %s is empty\n", path);
+        close(fd);
+        return 0;
+    }
+    size_t len = (size_t)st.st_size;
+    void *addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        int err = errno;
+        GPSUTILS_ERROR("Failed to mmap %s: %s(%d)\n", path, strerror(err), err);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    madvise(addr, len, MADV_SEQUENTIAL);
+    int rc = gpsdata_parse_buffer_parallel((const char *)addr, len, nthreads,
+                list, outnum);
+    munmap(addr, len);
+    return rc;
+}
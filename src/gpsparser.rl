@@ -9,6 +9,9 @@
 #include <gpsconfig.h>
 #include <gpsutils.h>
 #include <gpsdata.h>
+// log calls in this file go to the parser's log sink, if it has one
+#undef GPSUTILS_LOG_SINK
+#define GPSUTILS_LOG_SINK ((fsm) ? (fsm)->logsink : NULL)
 #ifdef LIBGPS_MTK3339_TIME_WITH_SYS_TIME
 # include <sys/time.h>
 # include <time.h>
@@ -38,23 +41,75 @@ struct gpsdata_parser_t {
     * list but better to use a list than an array
     * the items in this list are added in by the save function
     */
-    gpsdata_data_t *items;
+    gpsdata_list_t items;
+    // the items are drawn from this pool if it is set
+    gpsdata_pool_t *pool;
+    const gpsutils_logsink_t *logsink; // used instead of GPSUTILS_LOG_PTR if set
+    gpsdata_latest_t *latest; // updated with every delivered item if set
+    uint32_t filter; // GPSDATA_MSGID_MASK() of the messages to deliver
+    bool resync; // skip to the next message on error instead of failing
+    gpsdata_parser_stats_t stats;
+    // host receive times. rx_usec is the arrival of the last byte of the
+    // buffer being parsed, 0 if unknown
+    int64_t rx_pending_usec; // for the next parse call
+    int64_t rx_usec;
+    uint32_t rx_byte_nsec; // time to receive a byte at the baud rate
+    gpsdata_rx_offset_stats_t rx_offset;
+    double rx_offset_m2; // sum of squared differences from the mean
+    // if set, each saved message is handed to this callback instead of being
+    // added to the items list. used by gpsdata_parser_parse_cb()
+    gpsdata_parser_cb_t cb;
+    void *cb_userdata;
+    size_t cb_count;
+    // if non-zero, parsing stops once cb_count reaches this value
+    size_t cb_limit;
+    // each message is filled in here and then delivered
+    gpsdata_data_t cb_item;
+    // PMTK001 acknowledgements are handed here instead of being delivered
+    gpsdata_parser_ack_cb_t ack_cb;
+    void *ack_userdata;
+    // epoch fusion. the open epoch is merged into fused
+    bool fusion;
+    uint32_t fusion_timeout_ms;
+    bool fused_active;
+    int64_t fused_key; // time of day in ms of the epoch, -1 until known
+    uint64_t fused_start_ms; // gpsutils_monotonic_ms() when the epoch began
+    gpsdata_data_t fused;
+    gpsdata_data_t fuse_item; // the message being merged
+    // GPGSV groups span messages so these are not part of the message state
+    gpsdata_skyview_t skyview; // the last complete group
+    gpsdata_skyview_t gsv_group; // the group being assembled
+    uint8_t gsv_group_next; // index of the next message of the group, 0 if none
+    uint8_t gsv_group_count; // number of messages in the group
     // used to store the most recent date from the GPRMC message
     // since it is like a delta feed and we may not have that info
     struct tm rmc_tm;
+    int64_t rmc_day_epoch; // UTC midnight of the rmc_tm date
+    bool rmc_tm_warned; // warned once that rmc_tm is not available yet
 
     /* internal portion of the FSM to track each message */
     struct tm _tm;
     uint32_t _tm_msec;
     gpsdata_latlon_t _lll;
-    uint32_t _tmp_real[4];
-    float _tmp_float;
+    uint32_t _lll_min_e4; // minutes of _lll in units of 1e-4
+    // numbers are accumulated as an integer and a power of 10 divisor
+#define FSM_TMP_NUM_MAX INT64_C(100000000000)
+    int64_t _tmp_num;
+    int64_t _tmp_scale;
+    bool _tmp_neg;
+    bool _tmp_set; // false if the field is empty
+    bool _tmp_overflow; // the integer part did not fit
     uint32_t _calc_checksum;
     uint32_t _checksum;
+    const char *_cksum_start; // start of the span not yet XOR'ed, in this buffer only
+    bool _cksum_active; // inside the span between '$' and '*'
+    bool _cksum_verified; // checksum already verified by looking ahead
 
     gpsdata_msgid_t _msgid;
     gpsdata_latlon_t _lat;
     gpsdata_latlon_t _lon;
+    uint32_t _lat_min_e4;
+    uint32_t _lon_min_e4;
     gpsdata_posfix_t _posfix;
     gpsdata_mode_t mode1;
     gpsdata_mode_t mode2;
@@ -71,17 +126,20 @@ struct gpsdata_parser_t {
     uint8_t  _satellites_used_idx;
     float _hdop;
     float _altitude;
+    int32_t _altitude_mm;
     float _geoidal;
     float _pdop;
     float _vdop;
     float _speed_knots;
     float _speed_kmph;
+    int32_t _speed_mmps; // from the speed in knots
+    int32_t _speed_kmph_mmps; // from the speed in km/hr
     float _course_degrees; // true heading
     float _heading_degrees; // magnetic heading
     float _magvar_degrees; // magnetic variation
     gpsdata_direction_t _magvar_direction; // magnetic variation direction
 
-#define FSM_GSV_SAT_MAX 9
+#define FSM_GSV_SAT_MAX 4
     struct gpsdata_parser_gsv_t {
         uint8_t satellite_id; // values 1-32. sometimes can be > 48
         uint8_t elevation; // values 0-90
@@ -90,8 +148,9 @@ struct gpsdata_parser_t {
         bool is_azimuth_null;
         uint8_t snr_cno; // null, 0-99.
         bool is_snr_cno_null; // true if null
-    } _gsv_sats[FSM_GSV_SAT_MAX]; // can handle a total of 9 messages at max
+    } _gsv_sats[FSM_GSV_SAT_MAX]; // the satellites of this message
     uint8_t _gsv_sat_idx;
+    int64_t _rx_usec; // arrival of the '$' of this message
 
     // PMTK command specific
     uint16_t _pmtkack_cmd;
@@ -105,6 +164,78 @@ struct gpsdata_parser_t {
     gpsdata_firmware_t fw;
 };
 
+static inline float gpsdata_parser_internal_tmp_float(const gpsdata_parser_t *fsm)
+{
+    if (!fsm->_tmp_set)
+        return NAN;
+    double v = (double)fsm->_tmp_num / (double)fsm->_tmp_scale;
+    return (float)(fsm->_tmp_neg ? -v : v);
+}
+
+// the number multiplied by mul/div, rounded to the nearest integer
+static inline int64_t gpsdata_parser_internal_tmp_fixed(const gpsdata_parser_t *fsm,
+                int64_t mul, int64_t div)
+{
+    int64_t d = fsm->_tmp_scale * div;
+    int64_t v = (fsm->_tmp_num * mul + d / 2) / d;
+    return fsm->_tmp_neg ? -v : v;
+}
+
+static inline int32_t gpsdata_parser_internal_tmp_int32(const gpsdata_parser_t *fsm,
+                int64_t mul, int64_t div)
+{
+    if (!fsm->_tmp_set)
+        return GPSDATA_FIXED_UNSET;
+    int64_t v = gpsdata_parser_internal_tmp_fixed(fsm, mul, div);
+    return (v > INT32_MAX || v <= INT32_MIN) ? GPSDATA_FIXED_UNSET : (int32_t)v;
+}
+
+/* the message ID of a complete message starting with '$' at p, found before
+ * parsing it so that filtered messages can be skipped */
+static gpsdata_msgid_t gpsdata_parser_internal_peek_msgid(const char *p, size_t len)
+{
+    static const struct {
+        const char *name;
+        size_t len;
+        gpsdata_msgid_t msgid;
+    } msgids[] = {
+        { "GPGGA", 5, GPSDATA_MSGID_GPGGA },
+        { "GPGSA", 5, GPSDATA_MSGID_GPGSA },
+        { "GPGSV", 5, GPSDATA_MSGID_GPGSV },
+        { "GPRMC", 5, GPSDATA_MSGID_GPRMC },
+        { "GPVTG", 5, GPSDATA_MSGID_GPVTG },
+        { "GPGLL", 5, GPSDATA_MSGID_GPGLL },
+        { "PGTOP", 5, GPSDATA_MSGID_PGTOP },
+        { "PGACK", 5, GPSDATA_MSGID_PGTOP },
+        { "PMTK", 4, GPSDATA_MSGID_PMTK }
+    };
+    for (size_t i = 0; i < sizeof(msgids) / sizeof(msgids[0]); ++i) {
+        if (len > msgids[i].len && memcmp(p + 1, msgids[i].name, msgids[i].len) == 0)
+            return msgids[i].msgid;
+    }
+    return GPSDATA_MSGID_UNSET;
+}
+
+static inline bool gpsdata_parser_internal_is_filtered(const gpsdata_parser_t *fsm,
+                gpsdata_msgid_t msgid)
+{
+    return (fsm->filter & GPSDATA_MSGID_MASK(msgid)) == 0;
+}
+
+// signed degrees in units of 1e-7
+static inline int32_t gpsdata_parser_internal_latlon_e7(const gpsdata_latlon_t *ll,
+                uint32_t min_e4)
+{
+    if (ll->direction == GPSDATA_DIRECTION_UNSET || ll->degrees == SHRT_MIN)
+        return GPSDATA_FIXED_UNSET;
+    // 1e-4 minutes is 1e3/60 units of 1e-7 degrees
+    int64_t v = (int64_t)ll->degrees * 10000000 + ((int64_t)min_e4 * 50 + 1) / 3;
+    if (ll->direction == GPSDATA_DIRECTION_SOUTH ||
+        ll->direction == GPSDATA_DIRECTION_WEST)
+        v = -v;
+    return (int32_t)v;
+}
+
 %%{
     machine gpsdata_parser_fsm;
     alphtype char;
@@ -114,6 +245,11 @@ struct gpsdata_parser_t {
     variable eof fsm->eof;
 
     action xn_clean_state { if (fsm->clean_state) fsm->clean_state(fsm); }
+    action xn_rx_time {
+        // the bytes after the '$' in this buffer took this long to arrive
+        fsm->_rx_usec = (fsm->rx_usec == 0) ? 0 : fsm->rx_usec -
+                (int64_t)((uint64_t)(fsm->pe - 1 - fpc) * fsm->rx_byte_nsec / 1000);
+    }
     action xn_msgid_gpgga { fsm->_msgid = GPSDATA_MSGID_GPGGA; }
     action xn_msgid_gpgsa { fsm->_msgid = GPSDATA_MSGID_GPGSA; }
     action xn_msgid_gpgsv { fsm->_msgid = GPSDATA_MSGID_GPGSV; }
@@ -153,35 +289,39 @@ struct gpsdata_parser_t {
         fsm->_lll.degrees = 0;
         fsm->_lll.minutes = 0;
         fsm->_lll.direction = GPSDATA_DIRECTION_UNSET;
+        fsm->_lll_min_e4 = 0;
     }
     action xn_lat_0_dd { fsm->_lll.degrees += (fc - '0'); }
     action xn_lat_1_dd { fsm->_lll.degrees += 10 * (fc - '0'); }
     action xn_lat_2_dd { fsm->_lll.degrees += 100 * (fc - '0'); }
-    action xn_lat_0_mm { fsm->_lll.minutes += (fc - '0'); }
-    action xn_lat_1_mm { fsm->_lll.minutes += 10 * (fc - '0'); }
-    action xn_lat_0_ss { fsm->_lll.minutes += 0.0001 * (fc - '0'); }
-    action xn_lat_1_ss { fsm->_lll.minutes += 0.001 * (fc - '0'); }
-    action xn_lat_2_ss { fsm->_lll.minutes += 0.01 * (fc - '0'); }
-    action xn_lat_3_ss { fsm->_lll.minutes += 0.1 * (fc - '0'); }
+    ### minutes are accumulated in integer units of 1e-4
+    action xn_lat_0_mm { fsm->_lll_min_e4 += 10000 * (fc - '0'); }
+    action xn_lat_1_mm { fsm->_lll_min_e4 += 100000 * (fc - '0'); }
+    action xn_lat_0_ss { fsm->_lll_min_e4 += (fc - '0'); }
+    action xn_lat_1_ss { fsm->_lll_min_e4 += 10 * (fc - '0'); }
+    action xn_lat_2_ss { fsm->_lll_min_e4 += 100 * (fc - '0'); }
+    action xn_lat_3_ss { fsm->_lll_min_e4 += 1000 * (fc - '0'); }
     action xn_latitude {
         fsm->_lat.direction = fsm->_lll.direction;
         fsm->_lat.degrees = fsm->_lll.degrees;
-        fsm->_lat.minutes = fsm->_lll.minutes;
+        fsm->_lat.minutes = fsm->_lll_min_e4 / 10000.0f;
+        fsm->_lat_min_e4 = fsm->_lll_min_e4;
     }
     action xn_longitude {
         fsm->_lon.direction = fsm->_lll.direction;
         fsm->_lon.degrees = fsm->_lll.degrees;
-        fsm->_lon.minutes = fsm->_lll.minutes;
+        fsm->_lon.minutes = fsm->_lll_min_e4 / 10000.0f;
+        fsm->_lon_min_e4 = fsm->_lll_min_e4;
     }
     action xn_magvariation {
         fsm->_magvar_direction = GPSDATA_DIRECTION_UNSET;
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_magvar_degrees = fsm->_tmp_float;
+        if (fsm->_tmp_set) {
+            fsm->_magvar_degrees = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             GPSUTILS_DEBUG("GPVTG magnetic variation is empty/nan\n");
             fsm->_magvar_degrees = NAN;
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
     action xn_latitude_ns {
         fsm->_lat.direction = (fc == 'N') ? GPSDATA_DIRECTION_NORTH : GPSDATA_DIRECTION_SOUTH;
@@ -270,118 +410,125 @@ struct gpsdata_parser_t {
     action xn_num_sats {
         fsm->_num_sats = fsm->_num_sats * 10 + (fc - '0');
     }
+    ### numbers are kept as integers. the fields convert them as needed
+    ### the start action may run before or after the sign action on '-', so it
+    ### sets the sign itself
     action xn_real_start {
-        fsm->_tmp_real[0] = 0;
-        fsm->_tmp_real[1] = 0;
-        fsm->_tmp_real[2] = 1;
-        fsm->_tmp_real[3] = 1;
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_num = 0;
+        fsm->_tmp_scale = 1;
+        fsm->_tmp_neg = (fc == '-');
+        fsm->_tmp_set = false;
+        fsm->_tmp_overflow = false;
     }
     action xn_real_front {
-        fsm->_tmp_real[0]  = fsm->_tmp_real[0] * 10 + (fc - '0');
+        if (fsm->_tmp_num < FSM_TMP_NUM_MAX)
+            fsm->_tmp_num = fsm->_tmp_num * 10 + (fc - '0');
+        else
+            fsm->_tmp_overflow = true;
     }
     action xn_real_back {
-        fsm->_tmp_real[1]  = fsm->_tmp_real[1] * 10 + (fc - '0');
-        fsm->_tmp_real[2] *= 10;
+        // decimals beyond what we can hold are dropped
+        if (fsm->_tmp_num < FSM_TMP_NUM_MAX) {
+            fsm->_tmp_num = fsm->_tmp_num * 10 + (fc - '0');
+            fsm->_tmp_scale *= 10;
+        }
     }
     action xn_real_sign {
-        fsm->_tmp_real[3] = -1;
+        fsm->_tmp_neg = true;
     }
     action xn_real_end {
-        // if we do not use float here the compiler does the RHS in ints and
-        // then converts to float which is not what we want
-        fsm->_tmp_float = ((float)fsm->_tmp_real[0] +
-            ((float)fsm->_tmp_real[1] / fsm->_tmp_real[2])) * (float)fsm->_tmp_real[3];
-        /*GPSUTILS_DEBUG("tmp_real: %d %d %d %d %f\n",
-            fsm->_tmp_real[0], fsm->_tmp_real[1],
-            fsm->_tmp_real[2], fsm->_tmp_real[3],
-            fsm->_tmp_float);*/
+        // a number that is too large is left unset instead of being cut short
+        if (fsm->_tmp_overflow) {
+            GPSUTILS_WARN("Number in message %s is too large, ignoring it\n",
+                    gpsdata_msgid_tostring(fsm->_msgid));
+        }
+        fsm->_tmp_set = !fsm->_tmp_overflow;
     }
 
     action xn_hdop {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_hdop = fsm->_tmp_float;
+        if (fsm->_tmp_set) {
+            fsm->_hdop = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             fsm->_hdop = NAN;
             GPSUTILS_DEBUG("HDOP is empty/nan\n");
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
     action xn_pdop {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_pdop = fsm->_tmp_float;
+        if (fsm->_tmp_set) {
+            fsm->_pdop = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             fsm->_pdop = NAN;
             GPSUTILS_DEBUG("PDOP is empty/nan\n");
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
     action xn_vdop {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_vdop = fsm->_tmp_float;
+        if (fsm->_tmp_set) {
+            fsm->_vdop = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             fsm->_vdop = NAN;
             GPSUTILS_DEBUG("VDOP is empty/nan\n");
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
     action xn_altitude {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_altitude = fsm->_tmp_float;
-        } else {
-            fsm->_altitude = NAN;
-        }
-        fsm->_tmp_float = NAN;
+        fsm->_altitude = gpsdata_parser_internal_tmp_float(fsm);
+        fsm->_altitude_mm = gpsdata_parser_internal_tmp_int32(fsm, 1000, 1);
+        fsm->_tmp_set = false;
     }
     action xn_geoidal {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_geoidal = fsm->_tmp_float;
+        if (fsm->_tmp_set) {
+            fsm->_geoidal = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             fsm->_geoidal = NAN;
             GPSUTILS_DEBUG("Geoidal is empty/nan\n");
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
     action xn_speed_knots {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_speed_knots = fsm->_tmp_float;
+        // 1 knot is 1852m/hr
+        fsm->_speed_mmps = gpsdata_parser_internal_tmp_int32(fsm, 1852000, 3600);
+        if (fsm->_tmp_set) {
+            fsm->_speed_knots = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             fsm->_speed_knots = NAN;
             GPSUTILS_DEBUG("Speed (knots) is empty/nan\n");
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
     action xn_speed_kmph {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_speed_kmph = fsm->_tmp_float;
+        fsm->_speed_kmph_mmps = gpsdata_parser_internal_tmp_int32(fsm, 1000000, 3600);
+        if (fsm->_tmp_set) {
+            fsm->_speed_kmph = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             fsm->_speed_kmph = NAN;
             GPSUTILS_DEBUG("Speed (km/hr) is empty/nan\n");
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
     action xn_ground_course {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_course_degrees = fsm->_tmp_float;
+        if (fsm->_tmp_set) {
+            fsm->_course_degrees = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             fsm->_course_degrees = NAN;
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
     action xn_magnetic_heading {
-        if (!isnanf(fsm->_tmp_float)) {
-            fsm->_heading_degrees = fsm->_tmp_float;
+        if (fsm->_tmp_set) {
+            fsm->_heading_degrees = gpsdata_parser_internal_tmp_float(fsm);
         } else {
             GPSUTILS_DEBUG("GPVTG magnetic heading is empty/nan\n");
             fsm->_heading_degrees = NAN;
         }
-        fsm->_tmp_float = NAN;
+        fsm->_tmp_set = false;
     }
 
     action xn_satellites_used {
-        if (!isnanf(fsm->_tmp_float)) {
-            uint32_t sat = (uint32_t)(fsm->_tmp_float);
-            fsm->_tmp_float = NAN;
+        if (fsm->_tmp_set) {
+            uint32_t sat = (uint32_t)gpsdata_parser_internal_tmp_fixed(fsm, 1, 1);
+            fsm->_tmp_set = false;
             GPSUTILS_DEBUG("Satellite used: %d\n", sat);
             if (sat < 64 && fsm->_satellites_used_idx < 12) {
                 fsm->_satellites_used[fsm->_satellites_used_idx++] = sat;
@@ -390,28 +537,21 @@ struct gpsdata_parser_t {
             }
         } else {
             GPSUTILS_DEBUG("GPGSA satellites_used is empty/nan\n");
-            fsm->_satellites_used[fsm->_satellites_used_idx++] = 0;
+            if (fsm->_satellites_used_idx < 12)
+                fsm->_satellites_used[fsm->_satellites_used_idx++] = 0;
         }
     }
     action xn_gpgsv_msgcount {
         fsm->_num_msg_max = (fc - '0');
-        if (fsm->_gsv_sat_idx > fsm->_num_msg_max || fsm->_gsv_sat_idx > FSM_GSV_SAT_MAX) {
-            GPSUTILS_ERROR("_gsv_sat_idx %d > _num_msg_max %d || %d. Parser has an error\n",
-                    fsm->_gsv_sat_idx, fsm->_num_msg_max, FSM_GSV_SAT_MAX);
-            fbreak;
-        }
     }
+    ### the order of the messages in a group is checked when the message is saved
     action xn_gpgsv_msgindex {
         fsm->_num_msg_idx = (fc - '0'); // index is 1-based
-        if ((fsm->_num_msg_idx - 1) != fsm->_gsv_sat_idx) {
-            GPSUTILS_WARN("GPGSV message index %d does not match parser state internal message index %d\n",
-                fsm->_num_msg_idx, fsm->_gsv_sat_idx + 1);
-        }
     }
     action xn_satellite_id {
-        if (!isnanf(fsm->_tmp_float)) {
-            uint8_t num = ((uint32_t)(fsm->_tmp_float)) & 0xFF;
-            fsm->_tmp_float = NAN;
+        if (fsm->_tmp_set) {
+            uint8_t num = ((uint32_t)gpsdata_parser_internal_tmp_fixed(fsm, 1, 1)) & 0xFF;
+            fsm->_tmp_set = false;
             if (num >= 1 && num <= 99) {
                 GPSUTILS_DEBUG("Satellite ID: %d\n", num);
                 fsm->_gsv_sats[fsm->_gsv_sat_idx].satellite_id = num;
@@ -425,9 +565,9 @@ struct gpsdata_parser_t {
         }
     }
     action xn_elevation {
-        if (!isnanf(fsm->_tmp_float)) {
-            uint8_t num = ((uint32_t)(fsm->_tmp_float)) & 0xFF;
-            fsm->_tmp_float = NAN;
+        if (fsm->_tmp_set) {
+            uint8_t num = ((uint32_t)gpsdata_parser_internal_tmp_fixed(fsm, 1, 1)) & 0xFF;
+            fsm->_tmp_set = false;
             if (num <= 90) {
                 GPSUTILS_DEBUG("Elevation: %d\n", num);
                 fsm->_gsv_sats[fsm->_gsv_sat_idx].elevation = num;
@@ -444,9 +584,9 @@ struct gpsdata_parser_t {
         }
     }
     action xn_azimuth {
-        if (!isnanf(fsm->_tmp_float)) {
-            uint16_t num = ((uint32_t)(fsm->_tmp_float)) & 0x0000FFFF;
-            fsm->_tmp_float = NAN;
+        if (fsm->_tmp_set) {
+            uint16_t num = ((uint32_t)gpsdata_parser_internal_tmp_fixed(fsm, 1, 1)) & 0x0000FFFF;
+            fsm->_tmp_set = false;
             if (num < 360) {
                 GPSUTILS_DEBUG("Azimuth: %d\n", num);
                 fsm->_gsv_sats[fsm->_gsv_sat_idx].azimuth = num;
@@ -463,9 +603,9 @@ struct gpsdata_parser_t {
         }
     }
     action xn_snr_cno {
-        if (!isnanf(fsm->_tmp_float)) {
-            uint8_t num = ((uint32_t)(fsm->_tmp_float)) & 0xFF;
-            fsm->_tmp_float = NAN;
+        if (fsm->_tmp_set) {
+            uint8_t num = ((uint32_t)gpsdata_parser_internal_tmp_fixed(fsm, 1, 1)) & 0xFF;
+            fsm->_tmp_set = false;
             if (num <= 99) {
                 GPSUTILS_DEBUG("SNR C/No: %d\n", num);
                 fsm->_gsv_sats[fsm->_gsv_sat_idx].snr_cno = num;
@@ -480,7 +620,8 @@ struct gpsdata_parser_t {
             fsm->_gsv_sats[fsm->_gsv_sat_idx].snr_cno = 0;
             fsm->_gsv_sats[fsm->_gsv_sat_idx].is_snr_cno_null = true;
         }
-        fsm->_gsv_sat_idx++;// increment
+        if (fsm->_gsv_sat_idx < FSM_GSV_SAT_MAX)
+            fsm->_gsv_sat_idx++;// increment
         GPSUTILS_DEBUG("GPGSV gsv_sat_idx incremented to %d\n", fsm->_gsv_sat_idx);
     }
 
@@ -488,8 +629,8 @@ struct gpsdata_parser_t {
         fsm->_pmtkack_firmware = true;
     }
     action xn_pmtkack_command {
-        if (!isnanf(fsm->_tmp_float)) {
-            uint16_t num = ((uint32_t)(fsm->_tmp_float)) & 0x0000FFFF;
+        if (fsm->_tmp_set) {
+            uint16_t num = ((uint32_t)gpsdata_parser_internal_tmp_fixed(fsm, 1, 1)) & 0x0000FFFF;
             fsm->_pmtkack_cmd = num;
         } else {
             GPSUTILS_DEBUG("PMTK001 command invalid: nan/empty\n");
@@ -508,12 +649,55 @@ struct gpsdata_parser_t {
             fsm->_checksum = fsm->_checksum * 16 + ((toupper(fc) - 'A') + 10);
         }
     }
-    action xn_checksum_reset { fsm->_calc_checksum = 0; }
-    action xn_checksum_calculate { fsm->_calc_checksum ^= fc; }
+    ### the checksum is calculated over spans of the buffer instead of per
+    ### character. the span is closed at '*' or at the end of the buffer, so the
+    ### start pointer never refers to an earlier buffer.
+    action xn_checksum_reset {
+        fsm->_calc_checksum = 0;
+        fsm->_cksum_start = fpc;
+        fsm->_cksum_active = !fsm->_cksum_verified;
+    }
+    action xn_checksum_calculate {
+        if (fsm->_cksum_active) {
+            fsm->_calc_checksum ^= gpsutils_xor_bytes(fsm->_cksum_start,
+                                        fpc - fsm->_cksum_start);
+            fsm->_cksum_active = false;
+        }
+    }
+    ### if the whole message is in the buffer, verify its checksum before
+    ### parsing it and jump past the message if it is corrupt
+    action xn_checksum_lookahead {
+        size_t mlen = 0;
+        int vrc = gpsutils_checksum_verify(fpc, fsm->pe - fpc, &mlen);
+        if (vrc == 0) {
+            GPSUTILS_ERROR("Checksum does not match, skipping %zu bytes\n", mlen);
+            fsm->stats.checksum_errors++;
+            fexec fpc + mlen;
+            fgoto main;
+        }
+        fsm->_cksum_verified = (vrc > 0);
+        if (fsm->_cksum_verified && fsm->filter != GPSDATA_MSGID_MASK_ALL) {
+            // a filtered message is not parsed at all, except for GPRMC which
+            // has the date that the other messages need and PMTK if its
+            // acknowledgements are wanted
+            gpsdata_msgid_t msgid = gpsdata_parser_internal_peek_msgid(fpc, mlen);
+            if (msgid != GPSDATA_MSGID_UNSET && msgid != GPSDATA_MSGID_GPRMC &&
+                !(msgid == GPSDATA_MSGID_PMTK && fsm->ack_cb) &&
+                gpsdata_parser_internal_is_filtered(fsm, msgid)) {
+                fsm->stats.sentences[msgid]++;
+                fsm->stats.filter_drops[msgid]++;
+                fexec fpc + mlen;
+                fgoto main;
+            }
+        }
+    }
     action xn_checksum_verify {
-        if (fsm->_calc_checksum != fsm->_checksum) {
+        if (fsm->_cksum_verified) {
+            GPSUTILS_DEBUG("checksum: %x verified ahead\n", fsm->_checksum);
+        } else if (fsm->_calc_checksum != fsm->_checksum) {
             GPSUTILS_ERROR("Checksum does not match. Expected: %x Calculated: %x\n",
                     fsm->_checksum, fsm->_calc_checksum);
+            fsm->stats.checksum_errors++;
         } else {
             GPSUTILS_DEBUG("checksum: %x verified\n", fsm->_checksum);
         }
@@ -524,6 +708,15 @@ struct gpsdata_parser_t {
             fsm->save(fsm);
         }
     }
+    ### the save runs on the '$' of the next message when there is no space
+    ### between them, so stopping there would skip the entering actions of that
+    ### '$'. Parsing stops after them instead, with the next message begun.
+    action xn_cb_limit {
+        if (fsm->cb && fsm->cb_limit > 0 && fsm->cb_count >= fsm->cb_limit) {
+            GPSUTILS_DEBUG("callback limit of %zu reached, stopping\n", fsm->cb_limit);
+            fbreak;
+        }
+    }
     ### we store each character in an array since the message could be split up across buffers.
     ### so the fpc pointer can be on different stacks which cannot be used.
     action xn_fwstring_start {
@@ -554,6 +747,7 @@ struct gpsdata_parser_t {
             if (!(fsm->fw.firmware)) {
                 GPSUTILS_ERROR_NOMEM((strlen(fsm->_fw_buf) + 1) * sizeof(char));
                 fsm->fw.firmware = NULL;
+                fsm->stats.alloc_failures++;
             }
         }
     }
@@ -563,6 +757,7 @@ struct gpsdata_parser_t {
             if (!(fsm->fw.build_id)) {
                 GPSUTILS_ERROR_NOMEM((strlen(fsm->_fw_buf) + 1) * sizeof(char));
                 fsm->fw.build_id = NULL;
+                fsm->stats.alloc_failures++;
             }
         }
     }
@@ -572,6 +767,7 @@ struct gpsdata_parser_t {
             if (!(fsm->fw.chip_name)) {
                 GPSUTILS_ERROR_NOMEM((strlen(fsm->_fw_buf) + 1) * sizeof(char));
                 fsm->fw.chip_name = NULL;
+                fsm->stats.alloc_failures++;
             }
         }
     }
@@ -581,15 +777,17 @@ struct gpsdata_parser_t {
             if (!(fsm->fw.chip_version)) {
                 GPSUTILS_ERROR_NOMEM((strlen(fsm->_fw_buf) + 1) * sizeof(char));
                 fsm->fw.chip_version = NULL;
+                fsm->stats.alloc_failures++;
             }
         }
     }
 
     COMMA = ',';
     DOT = '.';
-    integer = '-' ? @xn_real_sign digit+ >xn_real_start $xn_real_front %xn_real_end;
-    real = '-' ? @xn_real_sign digit* >xn_real_start $xn_real_front DOT digit+ $xn_real_back %xn_real_end;
-    number = real | integer;
+    integer = ('-' ? @xn_real_sign digit+ $xn_real_front) >xn_real_start %xn_real_end;
+    number = ('-' ? @xn_real_sign
+              (digit+ $xn_real_front (DOT digit+ $xn_real_back)? |
+               DOT digit+ $xn_real_back)) >xn_real_start %xn_real_end;
     optional_integer = integer | zlen;
     optional_number = number | zlen;
     noncomma = alnum | '_' | '.' | '-';
@@ -710,9 +908,9 @@ struct gpsdata_parser_t {
     pmtkack = 'PMTK' @xn_msgid_pmtk '001' COMMA .
             integer %xn_pmtkack_command COMMA [0-4] @xn_pmtkack_flag COMMA ?;
 
-    message = '$' >xn_clean_state .
-        (gpgga | gpgsa | gpgsv | gprmc | gpvtg | gpgll | pgtop | firmware | pmtkack | pgack) >xn_checksum_reset $xn_checksum_calculate .
-        '*' xdigit{2} $xn_checksum_xdigit %xn_checksum_verify;
+    message = '$' >xn_clean_state >xn_rx_time >xn_checksum_lookahead >xn_cb_limit .
+        (gpgga | gpgsa | gpgsv | gprmc | gpvtg | gpgll | pgtop | firmware | pmtkack | pgack) >xn_checksum_reset .
+        '*' @xn_checksum_calculate xdigit{2} $xn_checksum_xdigit %xn_checksum_verify;
     ## bad data gets sent due to bad UART parsing
     action xn_fake_msg {
         GPSUTILS_WARN("fake message 0x00 0xFF received, ignoring\n");
@@ -732,10 +930,22 @@ static void gpsdata_parser_internal_clean_state(gpsdata_parser_t *fsm)
     fsm->_lll.direction = GPSDATA_DIRECTION_UNSET;
     fsm->_lll.degrees = SHRT_MIN;
     fsm->_lll.minutes = NAN;
-    memset(fsm->_tmp_real, 0, sizeof(fsm->_tmp_real));
-    fsm->_tmp_float = NAN;
+    fsm->_lll_min_e4 = 0;
+    fsm->_tmp_num = 0;
+    fsm->_tmp_scale = 1;
+    fsm->_tmp_neg = false;
+    fsm->_tmp_set = false;
+    fsm->_tmp_overflow = false;
+    fsm->_lat_min_e4 = 0;
+    fsm->_lon_min_e4 = 0;
+    fsm->_altitude_mm = GPSDATA_FIXED_UNSET;
+    fsm->_speed_mmps = GPSDATA_FIXED_UNSET;
+    fsm->_speed_kmph_mmps = GPSDATA_FIXED_UNSET;
     fsm->_calc_checksum = 0;
     fsm->_checksum = 0;
+    fsm->_cksum_start = NULL;
+    fsm->_cksum_active = false;
+    fsm->_cksum_verified = false;
     fsm->_msgid = GPSDATA_MSGID_UNSET;
     fsm->_lat.direction = GPSDATA_DIRECTION_UNSET;
     fsm->_lat.degrees = SHRT_MIN;
@@ -845,179 +1055,455 @@ static void gpsdata_parser_internal_dump_state(const gpsdata_parser_t *fsm, FILE
     }
 }
 
-static int gpsdata_parser_internal_save(gpsdata_parser_t *fsm)
+/* timestamp of a GPRMC message. its date is stored for the messages that
+ * follow */
+static int gpsdata_parser_internal_rmc_timestamp(gpsdata_parser_t *fsm,
+                struct timeval *tv)
 {
-    int rc = 0;
-    if (!fsm) {
-        GPSUTILS_ERROR("FSM's save function called but fsm is NULL. Inconsistent state\n");
+    // the date only changes once a day
+    int64_t day_epoch = fsm->rmc_day_epoch;
+    if (fsm->_tm.tm_mday != fsm->rmc_tm.tm_mday ||
+        fsm->_tm.tm_mon != fsm->rmc_tm.tm_mon ||
+        fsm->_tm.tm_year != fsm->rmc_tm.tm_year) {
+        day_epoch = gpsutils_get_day_epoch(&(fsm->_tm));
+    }
+    if (gpsutils_get_timeval_day(day_epoch, &(fsm->_tm), fsm->_tm_msec, tv) < 0)
         return -1;
+    // update this delta timestamp storage
+    memcpy(&(fsm->rmc_tm), &(fsm->_tm), sizeof(fsm->_tm));
+    fsm->rmc_day_epoch = day_epoch;
+    fsm->rmc_tm_warned = false;
+    return 0;
+}
+
+/* timestamp for messages that only carry the time of day, using the date of
+ * the last GPRMC message */
+static void gpsdata_parser_internal_timestamp(gpsdata_parser_t *fsm,
+                gpsdata_data_t *item, const char *msgid_str)
+{
+    // a valid rmc_tm
+    if (fsm->rmc_tm.tm_year > 0) {
+        if (gpsutils_get_timeval_day(fsm->rmc_day_epoch, &(fsm->_tm),
+                    fsm->_tm_msec, &(item->timestamp)) < 0) {
+            GPSUTILS_WARN("Message %s: invalid timestamp conversion\n",
+                    msgid_str);
+            item->is_valid_timestamp = false;
+        } else {
+            item->is_valid_timestamp = true;
+        }
+    } else {
+        // we still convert just in case we have knowledge of the date
+        // external to this library
+        gpsutils_get_timeval(&(fsm->_tm), fsm->_tm_msec, &(item->timestamp));
+        item->is_valid_timestamp = false;
+        if (!fsm->rmc_tm_warned) {
+            GPSUTILS_WARN("RMC date is unavailable, so timestamps are considered invalid until a GPRMC message is received. First seen for message %s\n", msgid_str);
+            fsm->rmc_tm_warned = true;
+        }
     }
-    gpsdata_data_t *item = NULL;
-    do {
-        GPSUTILS_DEBUG("Trying to save current message to list of items\n");
-        // saves a single message to the items list
-        item = calloc(1, sizeof(*item));
-        if (!item) {
-            GPSUTILS_ERROR_NOMEM(sizeof(*item));
-            rc = -1;
-            break;
+}
+
+/* adds the satellites of a GPGSV message to the group being assembled and
+ * publishes the group as the sky view once it is complete */
+static void gpsdata_parser_internal_skyview_add(gpsdata_parser_t *fsm)
+{
+    gpsdata_skyview_t *grp = &(fsm->gsv_group);
+    if (fsm->_num_msg_idx == 1) {
+        if (fsm->gsv_group_next != 0) {
+            GPSUTILS_WARN("GPGSV group is incomplete after %d of %d messages. Dropping\n",
+                    fsm->gsv_group_next - 1, fsm->gsv_group_count);
+            fsm->skyview.groups_dropped++;
         }
-        gpsdata_initialize(item);
-        // different messages have different handling
-        const char *msgid_str = gpsdata_msgid_tostring(fsm->_msgid);
-        item->msgid = fsm->_msgid;
-        switch (fsm->_msgid) {
-        case GPSDATA_MSGID_GPGGA:
-            memcpy(&(item->latitude), &(fsm->_lat), sizeof(fsm->_lat));
-            memcpy(&(item->longitude), &(fsm->_lon), sizeof(fsm->_lon));
-            // a valid rmc_tm
-            if (fsm->rmc_tm.tm_year > 0) {
-                fsm->_tm.tm_year = fsm->rmc_tm.tm_year;
-                fsm->_tm.tm_mon = fsm->rmc_tm.tm_mon;
-                fsm->_tm.tm_mday = fsm->rmc_tm.tm_mday;
-                if (gpsutils_get_timeval(&(fsm->_tm), fsm->_tm_msec,
-                    &(item->timestamp)) < 0) {
-                    GPSUTILS_WARN("Message %s: invalid timestamp conversion\n",
-                        msgid_str);
-                    item->is_valid_timestamp = false;
-                } else {
-                    item->is_valid_timestamp = true;
-                }
-            } else {
-                // we still convert just in case we have knowledge of the date
-                // external to this library
-                gpsutils_get_timeval(&(fsm->_tm), fsm->_tm_msec,
-                    &(item->timestamp));
+        grp->num_in_view = fsm->_num_sats;
+        grp->num_sats = 0;
+        fsm->gsv_group_count = fsm->_num_msg_max;
+        fsm->gsv_group_next = 1;
+    } else if (fsm->_num_msg_idx != fsm->gsv_group_next ||
+               fsm->_num_msg_max != fsm->gsv_group_count) {
+        GPSUTILS_WARN("GPGSV message %d of %d is out of order, expected %d of %d. Dropping\n",
+                fsm->_num_msg_idx, fsm->_num_msg_max, fsm->gsv_group_next,
+                fsm->gsv_group_count);
+        fsm->skyview.groups_dropped++;
+        fsm->gsv_group_next = 0;
+        return;
+    }
+    for (uint8_t i = 0; i < fsm->_gsv_sat_idx &&
+                grp->num_sats < GPSDATA_SKYVIEW_SATS_MAX; ++i) {
+        const struct gpsdata_parser_gsv_t *gsv = &(fsm->_gsv_sats[i]);
+        gpsdata_skyview_sat_t *sat = &(grp->sats[grp->num_sats++]);
+        sat->satellite_id = gsv->satellite_id;
+        sat->elevation = gsv->elevation;
+        sat->azimuth = gsv->azimuth;
+        sat->snr_cno = gsv->snr_cno;
+        sat->null_mask = (gsv->is_elevation_null ? GPSDATA_SKYVIEW_NULL_ELEVATION : 0) |
+                         (gsv->is_azimuth_null ? GPSDATA_SKYVIEW_NULL_AZIMUTH : 0) |
+                         (gsv->is_snr_cno_null ? GPSDATA_SKYVIEW_NULL_SNR : 0);
+    }
+    if (fsm->_num_msg_idx < fsm->gsv_group_count) {
+        fsm->gsv_group_next++;
+        return;
+    }
+    fsm->gsv_group_next = 0;
+    fsm->skyview.seq++;
+    fsm->skyview.num_in_view = grp->num_in_view;
+    fsm->skyview.num_sats = grp->num_sats;
+    memcpy(fsm->skyview.sats, grp->sats, grp->num_sats * sizeof(grp->sats[0]));
+    GPSUTILS_DEBUG("GPGSV sky view %" PRIu64 " has %d satellites\n",
+            fsm->skyview.seq, fsm->skyview.num_sats);
+}
+
+/* fills the item from the current message. returns 0 if the item is to be
+ * handed to the caller, 1 if the message is ignored and -1 on error */
+static int gpsdata_parser_internal_fill(gpsdata_parser_t *fsm, gpsdata_data_t *item)
+{
+    int rc = 0;
+    // different messages have different handling
+    const char *msgid_str = gpsdata_msgid_tostring(fsm->_msgid);
+    item->msgid = fsm->_msgid;
+    item->rx_usec = fsm->_rx_usec;
+    switch (fsm->_msgid) {
+    case GPSDATA_MSGID_GPGGA:
+        memcpy(&(item->latitude), &(fsm->_lat), sizeof(fsm->_lat));
+        memcpy(&(item->longitude), &(fsm->_lon), sizeof(fsm->_lon));
+        item->latitude_e7 = gpsdata_parser_internal_latlon_e7(&(fsm->_lat), fsm->_lat_min_e4);
+        item->longitude_e7 = gpsdata_parser_internal_latlon_e7(&(fsm->_lon), fsm->_lon_min_e4);
+        gpsdata_parser_internal_timestamp(fsm, item, msgid_str);
+        item->posfix = fsm->_posfix;
+        item->num_satellites = fsm->_num_sats;
+        item->altitude_meters = fsm->_altitude;
+        item->altitude_mm = fsm->_altitude_mm;
+        item->dop.hdop = fsm->_hdop;
+        break;
+    case GPSDATA_MSGID_GPGSA:
+        item->dop.pdop = fsm->_pdop;
+        item->dop.hdop = fsm->_hdop;
+        item->dop.vdop = fsm->_vdop;
+        item->gsa.selection = fsm->mode1;
+        item->gsa.fix = fsm->mode2;
+        item->gsa.num_used = 0;
+        for (uint8_t i = 0; i < fsm->_satellites_used_idx; ++i) {
+            if (fsm->_satellites_used[i] > 0)
+                item->gsa.satellites_used[item->gsa.num_used++] =
+                    (uint8_t)fsm->_satellites_used[i];
+        }
+        break;
+    case GPSDATA_MSGID_GPGSV:
+        // assembled into the sky view instead of being delivered
+        gpsdata_parser_internal_skyview_add(fsm);
+        rc = 1;
+        break;
+    case GPSDATA_MSGID_GPRMC:
+        memcpy(&(item->latitude), &(fsm->_lat), sizeof(fsm->_lat));
+        memcpy(&(item->longitude), &(fsm->_lon), sizeof(fsm->_lon));
+        item->latitude_e7 = gpsdata_parser_internal_latlon_e7(&(fsm->_lat), fsm->_lat_min_e4);
+        item->longitude_e7 = gpsdata_parser_internal_latlon_e7(&(fsm->_lon), fsm->_lon_min_e4);
+        item->mode = fsm->mode_common;
+        if (fsm->_is_valid) {
+            item->speed_knots = fsm->_speed_knots;
+            item->speed_mmps = fsm->_speed_mmps;
+            item->course_degrees = fsm->_course_degrees;
+            if (gpsdata_parser_internal_rmc_timestamp(fsm, &(item->timestamp)) < 0) {
+                GPSUTILS_WARN("Message %s: invalid timestamp conversion\n",
+                    msgid_str);
                 item->is_valid_timestamp = false;
-                GPSUTILS_WARN("RMC date is unavailable, so timestamp is considered invalid for message %s\n", msgid_str);
+            } else {
+                item->is_valid_timestamp = true;
             }
-            item->posfix = fsm->_posfix;
-            item->num_satellites = fsm->_num_sats;
-            item->altitude_meters = fsm->_altitude;
-            break;
-        case GPSDATA_MSGID_GPGSA:
-            GPSUTILS_DEBUG("Message %s: ignoring until needed in the future\n",
-                msgid_str);
-            rc = 1; //ignore
-            break;
-        case GPSDATA_MSGID_GPGSV:
-            GPSUTILS_DEBUG("Message %s: ignoring until needed in the future\n",
-                msgid_str);
-            rc = 1; //ignore
-            break;
-        case GPSDATA_MSGID_GPRMC:
+        } else {
+            GPSUTILS_WARN("%s message is not valid. Ignoring\n", msgid_str);
+            rc = 1;//ignore
+        }
+        break;
+    case GPSDATA_MSGID_GPGLL:
+        if (fsm->_is_valid) {
             memcpy(&(item->latitude), &(fsm->_lat), sizeof(fsm->_lat));
             memcpy(&(item->longitude), &(fsm->_lon), sizeof(fsm->_lon));
+            item->latitude_e7 = gpsdata_parser_internal_latlon_e7(&(fsm->_lat), fsm->_lat_min_e4);
+            item->longitude_e7 = gpsdata_parser_internal_latlon_e7(&(fsm->_lon), fsm->_lon_min_e4);
             item->mode = fsm->mode_common;
-            if (fsm->_is_valid) {
-                item->speed_knots = fsm->_speed_knots;
-                item->course_degrees = fsm->_course_degrees;
-                if (gpsutils_get_timeval(&(fsm->_tm), fsm->_tm_msec,
-                    &(item->timestamp)) < 0) {
-                    GPSUTILS_WARN("Message %s: invalid timestamp conversion\n",
-                        msgid_str);
-                    item->is_valid_timestamp = false;
-                } else {
-                    item->is_valid_timestamp = true;
-                    // update this delta timestamp storage
-                    memcpy(&(fsm->rmc_tm), &(fsm->_tm), sizeof(fsm->_tm));
-                }
-            } else {
-                GPSUTILS_WARN("%s message is not valid. Ignoring\n", msgid_str);
-                rc = 1;//ignore
-            }
-            break;
-        case GPSDATA_MSGID_GPGLL:
-            if (fsm->_is_valid) {
-                memcpy(&(item->latitude), &(fsm->_lat), sizeof(fsm->_lat));
-                memcpy(&(item->longitude), &(fsm->_lon), sizeof(fsm->_lon));
-                item->mode = fsm->mode_common;
-                // a valid rmc_tm
-                if (fsm->rmc_tm.tm_year > 0) {
-                    fsm->_tm.tm_year = fsm->rmc_tm.tm_year;
-                    fsm->_tm.tm_mon = fsm->rmc_tm.tm_mon;
-                    fsm->_tm.tm_mday = fsm->rmc_tm.tm_mday;
-                    if (gpsutils_get_timeval(&(fsm->_tm), fsm->_tm_msec,
-                                &(item->timestamp)) < 0) {
-                        GPSUTILS_WARN("Message %s: invalid timestamp conversion\n",
-                                msgid_str);
-                        item->is_valid_timestamp = false;
-                    } else {
-                        item->is_valid_timestamp = true;
-                    }
-                } else {
-                    // we still convert just in case we have knowledge of the date
-                    // external to this library
-                    gpsutils_get_timeval(&(fsm->_tm), fsm->_tm_msec,
-                            &(item->timestamp));
-                    item->is_valid_timestamp = false;
-                    GPSUTILS_WARN("RMC date is unavailable, so timestamp is considered invalid for message %s\n", msgid_str);
-                }
-            } else {
-                GPSUTILS_WARN("%s message is not valid. Ignoring\n", msgid_str);
-                rc = 1;//ignore
-            }
-            break;
-        case GPSDATA_MSGID_GPVTG:
-            item->mode = fsm->mode_common;
-            item->course_degrees = fsm->_course_degrees;
-            item->heading_degrees = fsm->_heading_degrees;
-            item->speed_knots = fsm->_speed_knots;
-            item->speed_kmph = fsm->_speed_kmph;
-            break;
-        case GPSDATA_MSGID_PGTOP:
-            GPSUTILS_DEBUG("Received message ID %s. Antenna state: %d CommandID: %d Enabled: %s\n",
-                msgid_str, fsm->_pgtop_value, fsm->_pgtop_fntype,
-                fsm->_pgtop_enabled ? "true" : "false");
-            if (fsm->_pgtop_fntype == 11) {
-                item->msgid = fsm->_msgid;
-                switch (fsm->_pgtop_value) {
-                case 1: item->antenna_status = GPSDATA_ANTENNA_SHORTED; break;
-                case 2: item->antenna_status = GPSDATA_ANTENNA_INTERNAL; break;
-                case 3: item->antenna_status = GPSDATA_ANTENNA_ACTIVE; break;
-                default:
-                    item->antenna_status = GPSDATA_ANTENNA_UNSET;
-                    GPSUTILS_WARN("Message %s: Antenna status cannot be %d. Ignoring\n",
-                                msgid_str, fsm->_pgtop_value);
-                    rc = 1; //ignore
-                    break;
-                }
-            } else {
-                GPSUTILS_WARN("Message %s: ignoring since %d is unsupported command ID\n",
-                    msgid_str, fsm->_pgtop_fntype);
-                rc = 1;//ignore
-            }
-            break;
-        case GPSDATA_MSGID_PMTK:
-            if (fsm->_pmtkack_firmware) {
-                GPSUTILS_DEBUG("Received message ID %s. FIRMWARE: %s BUILD_ID: %s CHIP_NAME: %s CHIP_VERSION: %s\n",
-                msgid_str, fsm->fw.firmware, fsm->fw.build_id, fsm->fw.chip_name, fsm->fw.chip_version);
-                // save the firmware into the item and set the fsm->fw to NULL
-                // since we do not need to store it, and can just move the
-                // memory to the object being returned.
-                memcpy(&(item->fwinfo), &(fsm->fw), sizeof(fsm->fw));
-                memset(&(fsm->fw), 0, sizeof(fsm->fw));
-                rc = 0;
-            } else {
-                GPSUTILS_DEBUG("Received message ID %s. Command %d Flag %d\n",
-                        msgid_str, fsm->_pmtkack_cmd, fsm->_pmtkack_flag);
-                rc = 1;//ignore
+            gpsdata_parser_internal_timestamp(fsm, item, msgid_str);
+        } else {
+            GPSUTILS_WARN("%s message is not valid. Ignoring\n", msgid_str);
+            rc = 1;//ignore
+        }
+        break;
+    case GPSDATA_MSGID_GPVTG:
+        item->mode = fsm->mode_common;
+        item->course_degrees = fsm->_course_degrees;
+        item->heading_degrees = fsm->_heading_degrees;
+        item->speed_knots = fsm->_speed_knots;
+        item->speed_kmph = fsm->_speed_kmph;
+        item->speed_mmps = (fsm->_speed_mmps != GPSDATA_FIXED_UNSET) ?
+                            fsm->_speed_mmps : fsm->_speed_kmph_mmps;
+        break;
+    case GPSDATA_MSGID_PGTOP:
+        GPSUTILS_DEBUG("Received message ID %s. Antenna state: %d CommandID: %d Enabled: %s\n",
+            msgid_str, fsm->_pgtop_value, fsm->_pgtop_fntype,
+            fsm->_pgtop_enabled ? "true" : "false");
+        if (fsm->_pgtop_fntype == 11) {
+            item->msgid = fsm->_msgid;
+            switch (fsm->_pgtop_value) {
+            case 1: item->antenna_status = GPSDATA_ANTENNA_SHORTED; break;
+            case 2: item->antenna_status = GPSDATA_ANTENNA_INTERNAL; break;
+            case 3: item->antenna_status = GPSDATA_ANTENNA_ACTIVE; break;
+            default:
+                item->antenna_status = GPSDATA_ANTENNA_UNSET;
+                GPSUTILS_WARN("Message %s: Antenna status cannot be %d. Ignoring\n",
+                            msgid_str, fsm->_pgtop_value);
+                rc = 1; //ignore
+                break;
             }
-            break;
-        default:
-            item->msgid = GPSDATA_MSGID_UNSET;
-            GPSUTILS_WARN("Unsupported message ID parsed: %d(%s)\n",
-                    fsm->_msgid, msgid_str);
-            rc = -1;
-            break;
+        } else {
+            GPSUTILS_WARN("Message %s: ignoring since %d is unsupported command ID\n",
+                msgid_str, fsm->_pgtop_fntype);
+            rc = 1;//ignore
+        }
+        break;
+    case GPSDATA_MSGID_PMTK:
+        if (fsm->_pmtkack_firmware) {
+            GPSUTILS_DEBUG("Received message ID %s. FIRMWARE: %s BUILD_ID: %s CHIP_NAME: %s CHIP_VERSION: %s\n",
+            msgid_str, fsm->fw.firmware, fsm->fw.build_id, fsm->fw.chip_name, fsm->fw.chip_version);
+            // save the firmware into the item and set the fsm->fw to NULL
+            // since we do not need to store it, and can just move the
+            // memory to the object being returned.
+            memcpy(&(item->fwinfo), &(fsm->fw), sizeof(fsm->fw));
+            memset(&(fsm->fw), 0, sizeof(fsm->fw));
+            rc = 0;
+        } else {
+            GPSUTILS_DEBUG("Received message ID %s. Command %d Flag %d\n",
+                    msgid_str, fsm->_pmtkack_cmd, fsm->_pmtkack_flag);
+            rc = 1;//ignore
+        }
+        break;
+    default:
+        item->msgid = GPSDATA_MSGID_UNSET;
+        GPSUTILS_WARN("Unsupported message ID parsed: %d(%s)\n",
+                fsm->_msgid, msgid_str);
+        rc = -1;
+        break;
+    }
+    return rc;
+}
+
+// counts a delivered item and updates the rx offset stats
+static void gpsdata_parser_internal_delivered(gpsdata_parser_t *fsm,
+                const gpsdata_data_t *item)
+{
+    fsm->stats.delivered[item->msgid]++;
+    if (item->rx_usec == 0 || !item->is_valid_timestamp)
+        return;
+    gpsdata_rx_offset_stats_t *ro = &(fsm->rx_offset);
+    int64_t offset = item->rx_usec - ((int64_t)item->timestamp.tv_sec * 1000000 +
+                        item->timestamp.tv_usec);
+    if (ro->count == 0) {
+        ro->min_usec = ro->max_usec = offset;
+    } else {
+        double d = (double)(offset - ro->last_usec);
+        ro->jitter_usec += (fabs(d) - ro->jitter_usec) / 16.0;
+        if (offset < ro->min_usec)
+            ro->min_usec = offset;
+        if (offset > ro->max_usec)
+            ro->max_usec = offset;
+    }
+    ro->count++;
+    ro->last_usec = offset;
+    // Welford's running mean and variance
+    double delta = (double)offset - ro->mean_usec;
+    ro->mean_usec += delta / (double)ro->count;
+    fsm->rx_offset_m2 += delta * ((double)offset - ro->mean_usec);
+}
+
+/* hands src to the callback or appends a copy of it to the items list */
+static int gpsdata_parser_internal_deliver(gpsdata_parser_t *fsm,
+                const gpsdata_data_t *src)
+{
+    if (fsm->latest)
+        gpsdata_latest_update(fsm->latest, src);
+    if (fsm->cb) {
+        fsm->cb(src, fsm->cb_userdata);
+        fsm->cb_count++;
+        gpsdata_parser_internal_delivered(fsm, src);
+        return 0;
+    }
+    gpsdata_data_t *item = NULL;
+    if (fsm->pool) {
+        item = gpsdata_pool_get(fsm->pool);
+        if (!item) {
+            GPSUTILS_ERROR("Unable to get an item from the pool\n");
+            fsm->stats.alloc_failures++;
+            return -1;
         }
-    } while (0);
-    // on failure or ignore message free the item
-    if (rc < 0 || rc > 0) {
-        GPSUTILS_FREE(item);
     } else {
-        // add to items list
-        LL_APPEND(fsm->items, item);
+        item = calloc(1, sizeof(*item));
+        if (!item) {
+            GPSUTILS_ERROR_NOMEM(sizeof(*item));
+            fsm->stats.alloc_failures++;
+            return -1;
+        }
+    }
+    gpsdata_pool_t *pool = item->pool;
+    memcpy(item, src, sizeof(*item));
+    item->pool = pool;
+    item->next = NULL;
+    gpsdata_list_append(&(fsm->items), item);
+    gpsdata_parser_internal_delivered(fsm, item);
+    return 0;
+}
+
+static int gpsdata_parser_internal_fusion_close(gpsdata_parser_t *fsm)
+{
+    if (!fsm->fused_active)
+        return 0;
+    fsm->fused_active = false;
+    GPSUTILS_DEBUG("Delivering epoch fused from messages 0x%08" PRIx32 "\n",
+            fsm->fused.fused_msgids);
+    return gpsdata_parser_internal_deliver(fsm, &(fsm->fused));
+}
+
+static void gpsdata_parser_internal_fusion_merge(gpsdata_data_t *fused,
+                const gpsdata_data_t *item)
+{
+    fused->fused_msgids |= GPSDATA_MSGID_MASK(item->msgid);
+    // the epoch arrived with its first message
+    if (fused->rx_usec == 0)
+        fused->rx_usec = item->rx_usec;
+    if (item->latitude.direction != GPSDATA_DIRECTION_UNSET) {
+        fused->latitude = item->latitude;
+        fused->latitude_e7 = item->latitude_e7;
+    }
+    if (item->longitude.direction != GPSDATA_DIRECTION_UNSET) {
+        fused->longitude = item->longitude;
+        fused->longitude_e7 = item->longitude_e7;
+    }
+    // a dated timestamp wins over one with the time of day only
+    if (item->is_valid_timestamp || (!fused->is_valid_timestamp &&
+            (item->timestamp.tv_sec != 0 || item->timestamp.tv_usec != 0))) {
+        fused->timestamp = item->timestamp;
+        fused->is_valid_timestamp = item->is_valid_timestamp;
+    }
+    if (item->mode != GPSDATA_MODE_UNSET)
+        fused->mode = item->mode;
+    if (item->msgid == GPSDATA_MSGID_GPGGA) {
+        fused->posfix = item->posfix;
+        fused->num_satellites = item->num_satellites;
+    }
+    if (!isnan(item->altitude_meters))
+        fused->altitude_meters = item->altitude_meters;
+    if (item->altitude_mm != GPSDATA_FIXED_UNSET)
+        fused->altitude_mm = item->altitude_mm;
+    if (!isnan(item->speed_knots))
+        fused->speed_knots = item->speed_knots;
+    if (!isnan(item->speed_kmph))
+        fused->speed_kmph = item->speed_kmph;
+    if (item->speed_mmps != GPSDATA_FIXED_UNSET)
+        fused->speed_mmps = item->speed_mmps;
+    if (!isnan(item->course_degrees))
+        fused->course_degrees = item->course_degrees;
+    if (!isnan(item->heading_degrees))
+        fused->heading_degrees = item->heading_degrees;
+    if (!isnan(item->dop.pdop))
+        fused->dop.pdop = item->dop.pdop;
+    if (!isnan(item->dop.hdop))
+        fused->dop.hdop = item->dop.hdop;
+    if (!isnan(item->dop.vdop))
+        fused->dop.vdop = item->dop.vdop;
+    if (item->gsa.fix != GPSDATA_MODE_UNSET)
+        fused->gsa = item->gsa;
+}
+
+/* merges the current message into the open epoch. returns 1 if the message
+ * does not take part in fusion, 0 if it was merged or ignored and -1 on error
+ */
+static int gpsdata_parser_internal_fuse(gpsdata_parser_t *fsm)
+{
+    int64_t key = -1;
+    switch (fsm->_msgid) {
+    case GPSDATA_MSGID_GPGGA:
+    case GPSDATA_MSGID_GPRMC:
+    case GPSDATA_MSGID_GPGLL:
+        key = (((int64_t)fsm->_tm.tm_hour * 60 + fsm->_tm.tm_min) * 60 +
+                fsm->_tm.tm_sec) * 1000 + fsm->_tm_msec;
+        break;
+    case GPSDATA_MSGID_GPVTG:
+    case GPSDATA_MSGID_GPGSA:
+        break;
+    default:
+        return 1;
+    }
+    int rc = 0;
+    if (fsm->fused_active && key >= 0 && fsm->fused_key >= 0 &&
+        key != fsm->fused_key) {
+        rc = gpsdata_parser_internal_fusion_close(fsm);
+    }
+    gpsdata_data_t *item = &(fsm->fuse_item);
+    gpsdata_initialize(item);
+    int frc = gpsdata_parser_internal_fill(fsm, item);
+    if (frc > 0)
+        fsm->stats.ignored++;
+    if (frc != 0)
+        return (frc < 0) ? frc : rc;
+    if (!fsm->fused_active) {
+        gpsdata_initialize(&(fsm->fused));
+        fsm->fused.msgid = item->msgid;
+        fsm->fused_key = -1;
+        fsm->fused_start_ms = gpsutils_monotonic_ms();
+        fsm->fused_active = true;
+    }
+    if (fsm->fused_key < 0)
+        fsm->fused_key = key;
+    gpsdata_parser_internal_fusion_merge(&(fsm->fused), item);
+    return rc;
+}
+
+static int gpsdata_parser_internal_save(gpsdata_parser_t *fsm)
+{
+    int rc = 0;
+    if (!fsm) {
+        GPSUTILS_ERROR("FSM's save function called but fsm is NULL. Inconsistent state\n");
+        return -1;
+    }
+    if (!fsm->_cksum_verified && fsm->_calc_checksum != fsm->_checksum) {
+        GPSUTILS_DEBUG("Ignoring %s with a bad checksum\n",
+                gpsdata_msgid_tostring(fsm->_msgid));
+        return 0;
+    }
+    fsm->stats.sentences[fsm->_msgid]++;
+    if (fsm->ack_cb && fsm->_msgid == GPSDATA_MSGID_PMTK && !fsm->_pmtkack_firmware) {
+        // acknowledgements reach the callback whatever the filter
+        fsm->ack_cb(fsm->_pmtkack_cmd, fsm->_pmtkack_flag, fsm->ack_userdata);
+    }
+    if (gpsdata_parser_internal_is_filtered(fsm, fsm->_msgid)) {
+        // only messages that were split across buffers get this far
+        fsm->stats.filter_drops[fsm->_msgid]++;
+        if (fsm->_msgid == GPSDATA_MSGID_GPRMC && fsm->_is_valid) {
+            struct timeval tv;
+            gpsdata_parser_internal_rmc_timestamp(fsm, &tv);
+        }
+        GPSUTILS_FREE(fsm->fw.firmware);
+        GPSUTILS_FREE(fsm->fw.build_id);
+        GPSUTILS_FREE(fsm->fw.chip_name);
+        GPSUTILS_FREE(fsm->fw.chip_version);
+        return 1;
+    }
+    if (fsm->fusion) {
+        rc = gpsdata_parser_internal_fuse(fsm);
+        if (rc <= 0)
+            return rc;
+    }
+    // the callback receives this parser-owned item and the items list a copy
+    gpsdata_data_t *item = &(fsm->cb_item);
+    gpsdata_initialize(item);
+    rc = gpsdata_parser_internal_fill(fsm, item);
+    if (rc > 0)
+        fsm->stats.ignored++;
+    if (rc == 0)
+        rc = gpsdata_parser_internal_deliver(fsm, item);
+    // a copy in the items list owns the firmware strings now
+    if (rc != 0 || fsm->cb) {
+        GPSUTILS_FREE(item->fwinfo.firmware);
+        GPSUTILS_FREE(item->fwinfo.build_id);
+        GPSUTILS_FREE(item->fwinfo.chip_name);
+        GPSUTILS_FREE(item->fwinfo.chip_version);
     }
     return rc;
 }
@@ -1028,8 +1514,12 @@ static void gpsdata_parser_internal_init(gpsdata_parser_t *fsm)
     if (fsm) {
         fsm->p = fsm->pe = fsm->eof = NULL;
         fsm->cs = 0;
-        fsm->items = NULL;
+        gpsdata_list_init(&(fsm->items));
         memset(&(fsm->rmc_tm), 0, sizeof(fsm->rmc_tm));
+        fsm->rmc_day_epoch = gpsutils_get_day_epoch(&(fsm->rmc_tm));
+        fsm->rmc_tm_warned = false;
+        fsm->fused_active = false;
+        fsm->gsv_group_next = 0;
         GPSUTILS_FREE(fsm->fw.firmware);
         GPSUTILS_FREE(fsm->fw.build_id);
         GPSUTILS_FREE(fsm->fw.chip_name);
@@ -1043,9 +1533,8 @@ static void gpsdata_parser_internal_init(gpsdata_parser_t *fsm)
 
 static void gpsdata_parser_internal_fini(gpsdata_parser_t *fsm)
 {
-    if (fsm && fsm->items) {
-        gpsdata_list_free(&(fsm->items));
-        fsm->items = NULL;
+    if (fsm && fsm->items.head) {
+        gpsdata_list_clear(&(fsm->items));
     }
 }
 
@@ -1057,6 +1546,10 @@ static void gpsdata_parser_internal_reset(gpsdata_parser_t *fsm)
         }
         gpsdata_parser_internal_fini(fsm);
         memset(&(fsm->rmc_tm), 0, sizeof(fsm->rmc_tm));
+        fsm->rmc_day_epoch = gpsutils_get_day_epoch(&(fsm->rmc_tm));
+        fsm->rmc_tm_warned = false;
+        fsm->fused_active = false;
+        fsm->gsv_group_next = 0;
     }
 }
 
@@ -1065,6 +1558,19 @@ static int gpsdata_parser_internal_execute(gpsdata_parser_t *fsm, const char *by
     if (!fsm || !bytes || len == 0) {
         return -1;
     }
+    fsm->stats.parse_calls++;
+    fsm->rx_usec = fsm->rx_pending_usec;
+    fsm->rx_pending_usec = 0;
+    if (fsm->fused_active && fsm->fusion_timeout_ms > 0 &&
+        gpsutils_monotonic_ms() - fsm->fused_start_ms >= fsm->fusion_timeout_ms) {
+        if (gpsdata_parser_internal_fusion_close(fsm) < 0)
+            return -1;
+        if (fsm->cb && fsm->cb_limit > 0 && fsm->cb_count >= fsm->cb_limit) {
+            // the epoch took the last row, parse the buffer next time
+            fsm->p = bytes;
+            return 0;
+        }
+    }
     if (fsm->cs == %%{ write first_final; }%%) {
         // parsing has not begun yet
         // find the first $ sign
@@ -1088,15 +1594,65 @@ static int gpsdata_parser_internal_execute(gpsdata_parser_t *fsm, const char *by
         fsm->p = bytes;
         fsm->pe = bytes + len;
     }
-    %% write exec;
-    if (fsm->cs == %%{ write error; }%%) {
+    if (fsm->_cksum_active) // the message continues from the previous buffer
+        fsm->_cksum_start = fsm->p;
+    int errors = 0;
+    while (1) {
+        %% write exec;
+        if (fsm->cs != %%{ write error; }%%)
+            break;
         size_t errlen = fsm->pe - fsm->p;
-        GPSUTILS_ERROR("Error in parsing. fsm->cs: %d\t Len: %zu Buffer: \n",
-                       fsm->cs, errlen);
-        gpsutils_hex_dump((const uint8_t *)fsm->p, errlen, GPSUTILS_LOG_PTR);
-        return -1;
+        if (!fsm->resync) {
+            GPSUTILS_ERROR("Error in parsing. fsm->cs: %d\t Len: %zu Buffer: \n",
+                           fsm->cs, errlen);
+            gpsutils_hex_dump((const uint8_t *)fsm->p, errlen, GPSUTILS_LOG_PTR);
+            fsm->stats.bytes += (uint64_t)(fsm->p - bytes);
+            return -1;
+        }
+        // skip to the next message. the character that caused the error may
+        // itself be the start of the next message
+        const char *next = NULL;
+        if (errlen > 0) {
+            next = (*fsm->p == '$') ? fsm->p : memchr(fsm->p + 1, '$', errlen - 1);
+        }
+        size_t dropped = next ? (size_t)(next - fsm->p) : errlen;
+        errors++;
+        fsm->stats.resync_errors++;
+        fsm->stats.resync_dropped += dropped;
+        GPSUTILS_WARN("Error in parsing. fsm->cs: %d, skipping %zu bytes to resync\n",
+                fsm->cs, dropped);
+        // the date of the last GPRMC message is retained
+        fsm->cs = %%{ write start; }%%;
+        if (fsm->clean_state)
+            fsm->clean_state(fsm);
+        if (!next) {
+            fsm->p = fsm->pe;
+            break;
+        }
+        fsm->p = next;
     }
-    return 0;
+    if (fsm->_cksum_active && fsm->_cksum_start) {
+        // the message continues into the next buffer
+        fsm->_calc_checksum ^= gpsutils_xor_bytes(fsm->_cksum_start,
+                                    fsm->p - fsm->_cksum_start);
+        fsm->_cksum_start = NULL;
+    }
+    fsm->stats.bytes += (uint64_t)(fsm->p - bytes);
+    return errors;
+}
+
+// used as the execute function while the latency histogram is enabled
+static int gpsdata_parser_internal_execute_timed(gpsdata_parser_t *fsm,
+                const char *bytes, size_t len)
+{
+    uint64_t start = gpsutils_monotonic_ns();
+    int rc = gpsdata_parser_internal_execute(fsm, bytes, len);
+    uint64_t ns = gpsutils_monotonic_ns() - start;
+    size_t idx = (ns > 0) ? (size_t)(64 - __builtin_clzll(ns)) : 0;
+    if (idx >= GPSDATA_PARSER_LATENCY_BUCKETS)
+        idx = GPSDATA_PARSER_LATENCY_BUCKETS - 1;
+    fsm->stats.latency_ns[idx]++;
+    return rc;
 }
 
 gpsdata_parser_t *gpsdata_parser_create()
@@ -1111,9 +1667,14 @@ gpsdata_parser_t *gpsdata_parser_create()
         fsm->clean_state = gpsdata_parser_internal_clean_state;
         fsm->dump_state = gpsdata_parser_internal_dump_state;
         fsm->save = gpsdata_parser_internal_save;
+        fsm->filter = GPSDATA_MSGID_MASK_ALL;
         if (fsm->init) {
             fsm->init(fsm);
         }
+        fsm->pool = gpsdata_pool_create(GPSDATA_POOL_DEFAULT_CAPACITY);
+        if (!fsm->pool) {
+            GPSUTILS_WARN("Unable to create item pool, items will be allocated on the heap\n");
+        }
     } else {
         GPSUTILS_ERROR_NOMEM(sizeof(gpsdata_parser_t));
     }
@@ -1135,10 +1696,41 @@ void gpsdata_parser_free(gpsdata_parser_t *fsm)
         GPSUTILS_FREE(fsm->fw.build_id);
         GPSUTILS_FREE(fsm->fw.chip_name);
         GPSUTILS_FREE(fsm->fw.chip_version);
+        // items still held by the caller keep the pool alive
+        gpsdata_pool_free(fsm->pool);
+        fsm->pool = NULL;
         GPSUTILS_FREE(fsm);
     }
 }
 
+int gpsdata_parser_set_pool_capacity(gpsdata_parser_t *fsm, size_t capacity)
+{
+    if (!fsm)
+        return -1;
+    gpsdata_pool_t *pool = NULL;
+    if (capacity > 0) {
+        pool = gpsdata_pool_create(capacity);
+        if (!pool) {
+            GPSUTILS_ERROR("Unable to create item pool of %zu items\n", capacity);
+            return -1;
+        }
+    }
+    gpsdata_pool_free(fsm->pool);
+    fsm->pool = pool;
+    return 0;
+}
+
+int gpsdata_parser_get_pool_stats(const gpsdata_parser_t *fsm, gpsdata_pool_stats_t *stats)
+{
+    if (!fsm || !stats)
+        return -1;
+    if (!fsm->pool) {
+        memset(stats, 0, sizeof(*stats));
+        return 0;
+    }
+    return gpsdata_pool_get_stats(fsm->pool, stats);
+}
+
 void gpsdata_parser_reset(gpsdata_parser_t *fsm)
 {
     if (fsm) {
@@ -1169,20 +1761,293 @@ int gpsdata_parser_parse(gpsdata_parser_t *fsm,
         return rc;
     }
     if (outp) {
-        if (fsm->items) {
-            ssize_t count = gpsdata_list_count(fsm->items);
-            if (onum && count >= 0)
-                *onum = (size_t)count;
-            GPSUTILS_DEBUG("adding %zd message items to the output list\n", count);
-            LL_CONCAT(*outp, fsm->items);
-            fsm->items = NULL;
+        if (fsm->items.head) {
+            if (onum)
+                *onum = fsm->items.count;
+            GPSUTILS_DEBUG("adding %zu message items to the output list\n",
+                    fsm->items.count);
+            // this walks the caller's list. use gpsdata_parser_parse_list()
+            // to avoid that
+            LL_CONCAT(*outp, fsm->items.head);
+            gpsdata_list_init(&(fsm->items));
         }
     } else {
         GPSUTILS_DEBUG("No list outp given, cleaning up parsed message items\n");
-        gpsdata_list_free(&(fsm->items));
-        fsm->items = NULL;
+        gpsdata_list_clear(&(fsm->items));
         if (onum)
             *onum = 0;
     }
     return rc;
 }
+
+int gpsdata_parser_parse_list(gpsdata_parser_t *fsm,
+            const char *data, size_t len,
+            gpsdata_list_t *list, size_t *onum)
+{
+    if (!fsm || !data || len == 0 || !list) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return -1;
+    }
+    if (!fsm->execute) {
+        GPSUTILS_ERROR("Invalid function setup for parsing\n");
+        return -1;
+    }
+    if (onum)
+        *onum = 0;
+    int rc = fsm->execute(fsm, data, len);
+    if (rc < 0) {
+        GPSUTILS_ERROR("Failed to parse data\n");
+        if (fsm->dump_state)
+            fsm->dump_state(fsm, GPSUTILS_LOG_PTR);
+        return rc;
+    }
+    if (onum)
+        *onum = fsm->items.count;
+    GPSUTILS_DEBUG("adding %zu message items to the output list\n", fsm->items.count);
+    gpsdata_list_concat(list, &(fsm->items));
+    return rc;
+}
+
+int gpsdata_parser_parse_cb(gpsdata_parser_t *fsm,
+            const char *data, size_t len,
+            gpsdata_parser_cb_t cb, void *userdata)
+{
+    if (!fsm || !data || len == 0 || !cb) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return -1;
+    }
+    if (!fsm->execute) {
+        GPSUTILS_ERROR("Invalid function setup for parsing\n");
+        return -1;
+    }
+    fsm->cb = cb;
+    fsm->cb_userdata = userdata;
+    fsm->cb_count = 0;
+    fsm->cb_limit = 0;
+    int rc = fsm->execute(fsm, data, len);
+    fsm->cb = NULL;
+    fsm->cb_userdata = NULL;
+    if (rc < 0) {
+        GPSUTILS_ERROR("Failed to parse data\n");
+        if (fsm->dump_state)
+            fsm->dump_state(fsm, GPSUTILS_LOG_PTR);
+        return rc;
+    }
+    return (int)fsm->cb_count;
+}
+
+static void gpsdata_parser_internal_columns_cb(const gpsdata_data_t *item, void *userdata)
+{
+    gpsdata_columns_t *cols = (gpsdata_columns_t *)userdata;
+    size_t row = cols->count;
+    if (cols->timestamp_usec) {
+        cols->timestamp_usec[row] = item->is_valid_timestamp ?
+            ((int64_t)item->timestamp.tv_sec * 1000000 + item->timestamp.tv_usec) : 0;
+    }
+    if (cols->latitude)
+        cols->latitude[row] = gpsdata_fixed_to_double(item->latitude_e7, 10000000);
+    if (cols->longitude)
+        cols->longitude[row] = gpsdata_fixed_to_double(item->longitude_e7, 10000000);
+    if (cols->altitude_meters)
+        cols->altitude_meters[row] = item->altitude_meters;
+    if (cols->speed_knots)
+        cols->speed_knots[row] = item->speed_knots;
+    if (cols->course_degrees)
+        cols->course_degrees[row] = item->course_degrees;
+    if (cols->msgid)
+        cols->msgid[row] = (uint8_t)item->msgid;
+    if (cols->posfix)
+        cols->posfix[row] = (uint8_t)item->posfix;
+    if (cols->num_satellites)
+        cols->num_satellites[row] = (uint8_t)item->num_satellites;
+    cols->count++;
+}
+
+int gpsdata_parser_parse_columns(gpsdata_parser_t *fsm,
+            const char *data, size_t len,
+            gpsdata_columns_t *cols, size_t *consumed)
+{
+    if (consumed)
+        *consumed = 0;
+    if (!fsm || !data || len == 0 || !cols) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return -1;
+    }
+    if (!fsm->execute) {
+        GPSUTILS_ERROR("Invalid function setup for parsing\n");
+        return -1;
+    }
+    if (cols->count >= cols->capacity) {
+        GPSUTILS_DEBUG("Columns are full, nothing parsed\n");
+        return 0;
+    }
+    fsm->cb = gpsdata_parser_internal_columns_cb;
+    fsm->cb_userdata = cols;
+    fsm->cb_count = 0;
+    fsm->cb_limit = cols->capacity - cols->count;
+    int rc = fsm->execute(fsm, data, len);
+    fsm->cb = NULL;
+    fsm->cb_userdata = NULL;
+    fsm->cb_limit = 0;
+    if (rc < 0) {
+        GPSUTILS_ERROR("Failed to parse data\n");
+        if (fsm->dump_state)
+            fsm->dump_state(fsm, GPSUTILS_LOG_PTR);
+        return rc;
+    }
+    if (consumed)
+        *consumed = (size_t)(fsm->p - data);
+    return (int)fsm->cb_count;
+}
+
+int gpsdata_parser_set_resync(gpsdata_parser_t *fsm, bool enable)
+{
+    if (!fsm)
+        return -1;
+    fsm->resync = enable;
+    return 0;
+}
+
+int gpsdata_parser_get_resync_stats(const gpsdata_parser_t *fsm,
+            size_t *errors, size_t *dropped_bytes)
+{
+    if (!fsm)
+        return -1;
+    if (errors)
+        *errors = (size_t)fsm->stats.resync_errors;
+    if (dropped_bytes)
+        *dropped_bytes = (size_t)fsm->stats.resync_dropped;
+    return 0;
+}
+
+int gpsdata_parser_get_stats(const gpsdata_parser_t *fsm, gpsdata_parser_stats_t *stats)
+{
+    if (!fsm || !stats)
+        return -1;
+    *stats = fsm->stats;
+    return 0;
+}
+
+int gpsdata_parser_reset_stats(gpsdata_parser_t *fsm)
+{
+    if (!fsm)
+        return -1;
+    memset(&(fsm->stats), 0, sizeof(fsm->stats));
+    memset(&(fsm->rx_offset), 0, sizeof(fsm->rx_offset));
+    fsm->rx_offset_m2 = 0;
+    return 0;
+}
+
+int gpsdata_parser_set_latency_histogram(gpsdata_parser_t *fsm, bool enable)
+{
+    if (!fsm)
+        return -1;
+    fsm->execute = enable ? gpsdata_parser_internal_execute_timed :
+                            gpsdata_parser_internal_execute;
+    return 0;
+}
+
+int gpsdata_parser_set_rx_time(gpsdata_parser_t *fsm, int64_t rx_usec)
+{
+    if (!fsm)
+        return -1;
+    fsm->rx_pending_usec = rx_usec;
+    return 0;
+}
+
+int gpsdata_parser_set_baudrate(gpsdata_parser_t *fsm, uint32_t baudrate)
+{
+    if (!fsm)
+        return -1;
+    // 8N1 framing sends 10 bits per byte
+    fsm->rx_byte_nsec = (baudrate > 0) ? (uint32_t)(10000000000ULL / baudrate) : 0;
+    return 0;
+}
+
+int gpsdata_parser_set_ack_cb(gpsdata_parser_t *fsm,
+            gpsdata_parser_ack_cb_t ack_cb, void *userdata)
+{
+    if (!fsm)
+        return -1;
+    fsm->ack_cb = ack_cb;
+    fsm->ack_userdata = ack_cb ? userdata : NULL;
+    return 0;
+}
+
+int gpsdata_parser_get_rx_offset_stats(const gpsdata_parser_t *fsm,
+            gpsdata_rx_offset_stats_t *stats)
+{
+    if (!fsm || !stats)
+        return -1;
+    *stats = fsm->rx_offset;
+    stats->stddev_usec = (fsm->rx_offset.count > 1) ?
+            sqrt(fsm->rx_offset_m2 / (double)(fsm->rx_offset.count - 1)) : 0.0;
+    return 0;
+}
+
+int gpsdata_parser_set_logsink(gpsdata_parser_t *fsm, const gpsutils_logsink_t *sink)
+{
+    if (!fsm)
+        return -1;
+    fsm->logsink = sink;
+    return 0;
+}
+
+int gpsdata_parser_set_latest(gpsdata_parser_t *fsm, gpsdata_latest_t *latest)
+{
+    if (!fsm)
+        return -1;
+    fsm->latest = latest;
+    return 0;
+}
+
+int gpsdata_parser_set_filter(gpsdata_parser_t *fsm, uint32_t mask)
+{
+    if (!fsm)
+        return -1;
+    fsm->filter = mask;
+    return 0;
+}
+
+int gpsdata_parser_get_filter_drops(const gpsdata_parser_t *fsm,
+            uint64_t drops[GPSDATA_MSGID_COUNT])
+{
+    if (!fsm || !drops)
+        return -1;
+    memcpy(drops, fsm->stats.filter_drops, sizeof(fsm->stats.filter_drops));
+    return 0;
+}
+
+int gpsdata_parser_set_fusion(gpsdata_parser_t *fsm, bool enable, uint32_t timeout_ms)
+{
+    if (!fsm)
+        return -1;
+    int rc = 0;
+    if (!enable && fsm->fused_active) {
+        // the open epoch waits in the items list like any other item
+        GPSUTILS_DEBUG("Delivering the open epoch as fusion is disabled\n");
+        rc = gpsdata_parser_internal_fusion_close(fsm);
+    }
+    fsm->fusion = enable;
+    fsm->fusion_timeout_ms = timeout_ms;
+    return rc;
+}
+
+int gpsdata_parser_flush(gpsdata_parser_t *fsm, gpsdata_list_t *list)
+{
+    if (!fsm || !list)
+        return -1;
+    if (gpsdata_parser_internal_fusion_close(fsm) < 0)
+        return -1;
+    int count = (int)fsm->items.count;
+    gpsdata_list_concat(list, &(fsm->items));
+    return count;
+}
+
+int gpsdata_parser_get_skyview(const gpsdata_parser_t *fsm, gpsdata_skyview_t *sv)
+{
+    if (!fsm || !sv)
+        return -1;
+    memcpy(sv, &(fsm->skyview), sizeof(*sv));
+    return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+#ifdef LIBGPS_MTK3339_HAVE_ERRNO_H
+    #include <errno.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_SYS_EVENTFD_H
+    #include <sys/eventfd.h>
+#endif
+#include <stdatomic.h>
+
+/** NOTE: the producer owns head and the consumer owns tail. Each side keeps a
+ * cached copy of the other's index and only reloads it when the cached copy
+ * says the ring is full or empty, so the shared cache lines are touched once
+ * per batch rather than once per fix **/
+
+// fixes converted on the stack at a time by gpsdata_ring_push_list()
+#define GPSDATA_RING_LIST_BATCH 16
+
+struct gpsdata_ring_t {
+    gpsdata_fix_t *slots;
+    size_t mask;
+    int efd;
+    char _pad0[64];
+    // written by the producer
+    atomic_size_t head;
+    size_t tail_cache;
+    atomic_uint_fast64_t overruns;
+    char _pad1[64];
+    // written by the consumer
+    atomic_size_t tail;
+    size_t head_cache;
+    char _pad2[64];
+};
+
+gpsdata_ring_t *gpsdata_ring_create(size_t capacity, bool wakeup)
+{
+    if (capacity == 0 || capacity > (SIZE_MAX >> 2) / sizeof(gpsdata_fix_t)) {
+        GPSUTILS_DEBUG("Invalid input arguments\n");
+        return NULL;
+    }
+    size_t cap = 2;
+    while (cap < capacity)
+        cap <<= 1;
+    gpsdata_ring_t *ring = calloc(1, sizeof(*ring));
+    if (!ring) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*ring));
+        return NULL;
+    }
+    ring->slots = calloc(cap, sizeof(*(ring->slots)));
+    if (!ring->slots) {
+        GPSUTILS_ERROR_NOMEM(cap * sizeof(*(ring->slots)));
+        GPSUTILS_FREE(ring);
+        return NULL;
+    }
+    ring->mask = cap - 1;
+    ring->efd = -1;
+    if (wakeup) {
+#ifdef LIBGPS_MTK3339_HAVE_SYS_EVENTFD_H
+        ring->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (ring->efd < 0) {
+            int err = errno;
+            GPSUTILS_ERROR("Failed to create eventfd: %s(%d)\n", strerror(err), err);
+            GPSUTILS_FREE(ring->slots);
+            GPSUTILS_FREE(ring);
+            return NULL;
+        }
+#else
+        GPSUTILS_ERROR("eventfd is not supported on this system\n");
+        GPSUTILS_FREE(ring->slots);
+        GPSUTILS_FREE(ring);
+        return NULL;
+#endif
+    }
+    atomic_init(&(ring->head), 0);
+    atomic_init(&(ring->tail), 0);
+    atomic_init(&(ring->overruns), 0);
+    ring->tail_cache = 0;
+    ring->head_cache = 0;
+    return ring;
+}
+
+void gpsdata_ring_free(gpsdata_ring_t *ring)
+{
+    if (ring) {
+        if (ring->efd >= 0)
+            close(ring->efd);
+        GPSUTILS_FREE(ring->slots);
+        GPSUTILS_FREE(ring);
+    }
+}
+
+size_t gpsdata_ring_push(gpsdata_ring_t *ring, const gpsdata_fix_t *fixes, size_t count)
+{
+    if (!ring || !fixes || count == 0)
+        return 0;
+    size_t cap = ring->mask + 1;
+    size_t head = atomic_load_explicit(&(ring->head), memory_order_relaxed);
+    size_t space = cap - (head - ring->tail_cache);
+    if (space < count) {
+        ring->tail_cache = atomic_load_explicit(&(ring->tail), memory_order_acquire);
+        space = cap - (head - ring->tail_cache);
+    }
+    size_t n = (count < space) ? count : space;
+    if (n > 0) {
+        size_t idx = head & ring->mask;
+        size_t first = (n < cap - idx) ? n : cap - idx;
+        memcpy(&(ring->slots[idx]), fixes, first * sizeof(*fixes));
+        if (n > first)
+            memcpy(&(ring->slots[0]), fixes + first, (n - first) * sizeof(*fixes));
+        atomic_store_explicit(&(ring->head), head + n, memory_order_release);
+#ifdef LIBGPS_MTK3339_HAVE_SYS_EVENTFD_H
+        if (ring->efd >= 0) {
+            uint64_t one = 1;
+            // EAGAIN only means the counter is already huge and readable
+            if (write(ring->efd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+                int err = errno;
+                GPSUTILS_WARN("Failed to signal eventfd: %s(%d)\n", strerror(err), err);
+            }
+        }
+#endif
+    }
+    if (n < count) {
+        atomic_fetch_add_explicit(&(ring->overruns), count - n, memory_order_relaxed);
+    }
+    return n;
+}
+
+size_t gpsdata_ring_push_list(gpsdata_ring_t *ring, const gpsdata_data_t *listp)
+{
+    gpsdata_fix_t batch[GPSDATA_RING_LIST_BATCH];
+    size_t count = 0;
+    size_t pushed = 0;
+    if (!ring)
+        return 0;
+    for (const gpsdata_data_t *item = listp; item; item = item->next) {
+        gpsdata_fix_from_data(&batch[count++], item);
+        if (count == GPSDATA_RING_LIST_BATCH) {
+            pushed += gpsdata_ring_push(ring, batch, count);
+            count = 0;
+        }
+    }
+    if (count > 0)
+        pushed += gpsdata_ring_push(ring, batch, count);
+    return pushed;
+}
+
+size_t gpsdata_ring_pop(gpsdata_ring_t *ring, gpsdata_fix_t *fixes, size_t max)
+{
+    if (!ring || !fixes || max == 0)
+        return 0;
+#ifdef LIBGPS_MTK3339_HAVE_SYS_EVENTFD_H
+    if (ring->efd >= 0) {
+        // clear the wakeup before looking at head. a push after this point
+        // signals again, so no wakeup is lost
+        uint64_t value = 0;
+        if (read(ring->efd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            int err = errno;
+            GPSUTILS_WARN("Failed to read eventfd: %s(%d)\n", strerror(err), err);
+        }
+    }
+#endif
+    size_t cap = ring->mask + 1;
+    size_t tail = atomic_load_explicit(&(ring->tail), memory_order_relaxed);
+    size_t avail = ring->head_cache - tail;
+    if (avail < max) {
+        ring->head_cache = atomic_load_explicit(&(ring->head), memory_order_acquire);
+        avail = ring->head_cache - tail;
+    }
+    size_t n = (max < avail) ? max : avail;
+    if (n > 0) {
+        size_t idx = tail & ring->mask;
+        size_t first = (n < cap - idx) ? n : cap - idx;
+        memcpy(fixes, &(ring->slots[idx]), first * sizeof(*fixes));
+        if (n > first)
+            memcpy(fixes + first, &(ring->slots[0]), (n - first) * sizeof(*fixes));
+        atomic_store_explicit(&(ring->tail), tail + n, memory_order_release);
+    }
+    return n;
+}
+
+uint64_t gpsdata_ring_overruns(const gpsdata_ring_t *ring)
+{
+    return ring ? atomic_load_explicit(&(ring->overruns), memory_order_relaxed) : 0;
+}
+
+int gpsdata_ring_fd(const gpsdata_ring_t *ring)
+{
+    return ring ? ring->efd : -1;
+}
@@ -9,45 +9,111 @@
 #ifdef LIBGPS_MTK3339_HAVE_ERRNO_H
     #include <errno.h>
 #endif
+#include <stdarg.h>
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
 
 volatile int gpsutils_loglevel = GPSUTILS_LOGLEVEL_INFO;
 
-static time_t gpsutils_timegm(struct tm *_tm)
-{
-#ifdef LIBGPS_MTK3339_HAVE_TIMEGM
-    return timegm(_tm);
-#else
-#warning "Using mktime() instead of timegm() and it is non-reentrant"
-    char *old_tz = getenv("TZ");
-    setenv("TZ", "UTC", 1);
-    time_t val = mktime(_tm);
-    if (old_tz) {
-        setenv("TZ", old_tz, 1);
-    } else {
-        unsetenv("TZ");
+// a log line longer than this is truncated for sinks
+#define GPSUTILS_LOG_LINE_MAX 512
+
+void gpsutils_log_printf(const gpsutils_logsink_t *sink, FILE *fp, int level,
+            const char *func, int line, const char *fmt, ...)
+{
+    static const char *names[] = { "ERROR", "WARN", "INFO", "DEBUG" };
+    const char *name = (level >= GPSUTILS_LOGLEVEL_ERROR &&
+                        level <= GPSUTILS_LOGLEVEL_DEBUG) ? names[level] : "LOG";
+    char buf[GPSUTILS_LOG_LINE_MAX];
+    int n = 0;
+    if (func)
+        n = snprintf(buf, sizeof(buf), "%s: [%s:%d] ", name, func, line);
+    else
+        n = snprintf(buf, sizeof(buf), "%s: ", name);
+    if (n < 0)
+        return;
+    if ((size_t)n >= sizeof(buf))
+        n = sizeof(buf) - 1;
+    va_list ap;
+    va_start(ap, fmt);
+    int m = vsnprintf(buf + n, sizeof(buf) - n, fmt, ap);
+    va_end(ap);
+    if (m < 0)
+        return;
+    size_t len = (size_t)n + (size_t)m;
+    if (sink && sink->write) {
+        if (len >= sizeof(buf))
+            len = sizeof(buf) - 1;
+        sink->write(sink->ctx, level, fmt, buf, len);
+    } else if (fp) {
+        if (len < sizeof(buf)) {
+            // a single write so lines from different threads do not mix
+            fwrite(buf, 1, len, fp);
+        } else {
+            fwrite(buf, 1, (size_t)n, fp);
+            va_start(ap, fmt);
+            vfprintf(fp, fmt, ap);
+            va_end(ap);
+        }
     }
-    return val;
-#endif
 }
 
-int gpsutils_get_timeval(const struct tm *tm1, uint32_t millisecs, struct timeval *tv)
+static int64_t gpsutils_floor_div(int64_t a, int64_t b)
+{
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+/* days since 1970-01-01 of the proleptic Gregorian date. month is 1-12 and
+ * day may be out of range, e.g. day 0 is the last day of the previous month.
+ * see http://howardhinnant.github.io/date_algorithms.html#days_from_civil */
+static int64_t gpsutils_days_from_civil(int64_t y, int64_t m, int64_t d)
+{
+    y -= (m <= 2) ? 1 : 0;
+    const int64_t era = gpsutils_floor_div(y, 400);
+    const int64_t yoe = y - era * 400; // [0, 399]
+    const int64_t doy = (153 * (m + ((m > 2) ? -3 : 9)) + 2) / 5 + d - 1; // [0, 365]
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy; // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+int64_t gpsutils_get_day_epoch(const struct tm *tm1)
+{
+    if (!tm1)
+        return 0;
+    // normalize the month like timegm() does
+    int64_t mon = tm1->tm_mon;
+    int64_t year = 1900 + (int64_t)tm1->tm_year + gpsutils_floor_div(mon, 12);
+    mon -= gpsutils_floor_div(mon, 12) * 12;
+    return gpsutils_days_from_civil(year, mon + 1, tm1->tm_mday) * 86400;
+}
+
+int gpsutils_get_timeval_day(int64_t day_epoch, const struct tm *tm1,
+            uint32_t millisecs, struct timeval *tv)
 {
     if (tm1 && tv) {
-        // the mktime/timegm functions may modify the tm structure so we copy it
-        struct tm tm2 = { 0 };
-        memcpy(&tm2, tm1, sizeof(struct tm));
-        tv->tv_sec = gpsutils_timegm(&tm2);
-        if (millisecs < 1000) {
-            tv->tv_usec = millisecs * 1000;
-        } else {
-            tv->tv_sec += millisecs / 1000;
-            tv->tv_usec = (millisecs % 1000) * 1000;
-        }
+        int64_t secs = day_epoch + (int64_t)tm1->tm_hour * 3600 +
+                        (int64_t)tm1->tm_min * 60 + tm1->tm_sec;
+        tv->tv_sec = (time_t)(secs + millisecs / 1000);
+        tv->tv_usec = (millisecs % 1000) * 1000;
         return 0;
     }
     return -1;
 }
 
+int gpsutils_get_timeval(const struct tm *tm1, uint32_t millisecs, struct timeval *tv)
+{
+    if (tm1 && tv) {
+        return gpsutils_get_timeval_day(gpsutils_get_day_epoch(tm1), tm1,
+                    millisecs, tv);
+    }
+    return -1;
+}
+
 void gpsutils_timer_start(gpsutils_timer_t *tt)
 {
     if (tt) {
@@ -69,6 +135,20 @@ void gpsutils_timer_stop(gpsutils_timer_t *tt)
     }
 }
 
+uint64_t gpsutils_monotonic_ms(void)
+{
+    struct timespec ts = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+uint64_t gpsutils_monotonic_ns(void)
+{
+    struct timespec ts = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
 void gpsutils_hex_dump(const uint8_t *inp, size_t inlen, FILE *fp)
 {
     if (!inp || inlen == 0 || !fp)
@@ -134,18 +214,110 @@ void gpsutils_string_toupper(char *s)
     }
 }
 
+#if defined(__SSE2__)
+static inline uint8_t gpsutils_xor_fold128(__m128i a)
+{
+    a = _mm_xor_si128(a, _mm_srli_si128(a, 8));
+    a = _mm_xor_si128(a, _mm_srli_si128(a, 4));
+    a = _mm_xor_si128(a, _mm_srli_si128(a, 2));
+    a = _mm_xor_si128(a, _mm_srli_si128(a, 1));
+    return (uint8_t)(_mm_cvtsi128_si32(a) & 0xFF);
+}
+#endif
+
+uint8_t gpsutils_xor_bytes(const char *buf, size_t len)
+{
+    uint8_t x = 0;
+    size_t i = 0;
+    if (!buf)
+        return 0;
+#if defined(__AVX2__)
+    if (len >= 32) {
+        __m256i acc = _mm256_setzero_si256();
+        for (; i + 32 <= len; i += 32) {
+            acc = _mm256_xor_si256(acc, _mm256_loadu_si256((const __m256i *)(buf + i)));
+        }
+        x ^= gpsutils_xor_fold128(_mm_xor_si128(_mm256_castsi256_si128(acc),
+                    _mm256_extracti128_si256(acc, 1)));
+    }
+#endif
+#if defined(__SSE2__)
+    if (len - i >= 16) {
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16) {
+            acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *)(buf + i)));
+        }
+        x ^= gpsutils_xor_fold128(acc);
+    }
+#elif defined(__ARM_NEON)
+    if (len - i >= 16) {
+        uint8x16_t acc = vdupq_n_u8(0);
+        for (; i + 16 <= len; i += 16) {
+            acc = veorq_u8(acc, vld1q_u8((const uint8_t *)(buf + i)));
+        }
+        uint8x8_t a = veor_u8(vget_low_u8(acc), vget_high_u8(acc));
+        uint64_t w = vget_lane_u64(vreinterpret_u64_u8(a), 0);
+        w ^= w >> 32;
+        w ^= w >> 16;
+        w ^= w >> 8;
+        x ^= (uint8_t)(w & 0xFF);
+    }
+#endif
+    // scalar fallback and tail: 8 bytes at a time
+    if (len - i >= 8) {
+        uint64_t w = 0;
+        for (; i + 8 <= len; i += 8) {
+            uint64_t v;
+            memcpy(&v, buf + i, sizeof(v));
+            w ^= v;
+        }
+        w ^= w >> 32;
+        w ^= w >> 16;
+        w ^= w >> 8;
+        x ^= (uint8_t)(w & 0xFF);
+    }
+    for (; i < len; ++i) {
+        x ^= (uint8_t)buf[i];
+    }
+    return x;
+}
+
 int gpsutils_checksum(const char *buf, ssize_t len)
 {
     if (buf) {
         if (len <= 0)
             len = strlen(buf);
-        int checksum = 0;
-        for (ssize_t i = 0; i < len; ++i) {
-            checksum ^= buf[i];
-        }
+        int checksum = gpsutils_xor_bytes(buf, (size_t)len);
         //GPSUTILS_DEBUG("checksum for msg: %s is %d(0x%02x)\n", buf, checksum, checksum);
         return checksum;
     } else {
         return -1;
     }
 }
+
+int gpsutils_checksum_verify(const char *msg, size_t len, size_t *msglen)
+{
+    if (msglen)
+        *msglen = 0;
+    if (!msg || len == 0 || msg[0] != '$')
+        return -1;
+    if (len > GPSUTILS_NMEA_MAX_LENGTH)
+        len = GPSUTILS_NMEA_MAX_LENGTH;
+    const char *star = memchr(msg + 1, '*', len - 1);
+    if (!star)
+        return -1;
+    size_t off = (size_t)(star - msg);
+    // the '*' belongs to a later message
+    if (memchr(msg + 1, '\n', off - 1) || memchr(msg + 1, '$', off - 1))
+        return -1;
+    if (off + 2 >= len)
+        return -1; // the checksum digits have not arrived yet
+    uint8_t hi = gpsutils_hex_parse(star[1]);
+    uint8_t lo = gpsutils_hex_parse(star[2]);
+    if (hi > 0x0F || lo > 0x0F)
+        return -1; // let the parser deal with the malformed checksum
+    uint8_t expected = (uint8_t)((hi << 4) | lo);
+    if (msglen)
+        *msglen = off + 3;
+    return (gpsutils_xor_bytes(msg + 1, off - 1) == expected) ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsdata.h>
+#ifdef LIBGPS_MTK3339_HAVE_ERRNO_H
+    #include <errno.h>
+#endif
+
+struct gpsdevice_writer_t {
+    int fd;
+    gpsdevice_writer_hook_t hook;
+    void *hook_userdata;
+    // the queued bytes are buf[head, tail)
+    size_t head;
+    size_t tail;
+    size_t capacity;
+    char buf[];
+};
+
+gpsdevice_writer_t *gpsdevice_writer_create(int fd, size_t capacity)
+{
+    if (fd < 0)
+        return NULL;
+    if (capacity == 0)
+        capacity = GPSDEVICE_WRITER_DEFAULT_CAPACITY;
+    gpsdevice_writer_t *w = calloc(1, sizeof(*w) + capacity);
+    if (!w) {
+        GPSUTILS_ERROR_NOMEM(sizeof(*w) + capacity);
+        return NULL;
+    }
+    w->fd = fd;
+    w->capacity = capacity;
+    return w;
+}
+
+void gpsdevice_writer_free(gpsdevice_writer_t *w)
+{
+    if (w) {
+        if (w->tail > w->head) {
+            GPSUTILS_WARN("Dropping %zu unwritten bytes for fd: %d\n",
+                    w->tail - w->head, w->fd);
+        }
+        GPSUTILS_FREE(w);
+    }
+}
+
+int gpsdevice_writer_set_hook(gpsdevice_writer_t *w, gpsdevice_writer_hook_t hook,
+                void *userdata)
+{
+    if (!w)
+        return -1;
+    w->hook = hook;
+    w->hook_userdata = hook ? userdata : NULL;
+    return 0;
+}
+
+int gpsdevice_writer_queue(gpsdevice_writer_t *w, const char *msg)
+{
+    if (!w || !msg)
+        return -1;
+    size_t len = strlen(msg);
+    if (len == 0)
+        return -1;
+    size_t pending = w->tail - w->head;
+    if (len > w->capacity - pending) {
+        GPSUTILS_ERROR("No room for %zu bytes with %zu bytes queued for fd: %d\n",
+                len, pending, w->fd);
+        return -1;
+    }
+    if (len > w->capacity - w->tail) {
+        memmove(w->buf, w->buf + w->head, pending);
+        w->head = 0;
+        w->tail = pending;
+    }
+    memcpy(w->buf + w->tail, msg, len);
+    w->tail += len;
+    if (pending == 0 && w->hook)
+        w->hook(w->fd, true, w->hook_userdata);
+    return 0;
+}
+
+ssize_t gpsdevice_writer_flush(gpsdevice_writer_t *w)
+{
+    if (!w)
+        return -1;
+    if (w->tail == w->head)
+        return 0;
+    while (w->tail > w->head) {
+        ssize_t nb = write(w->fd, w->buf + w->head, w->tail - w->head);
+        if (nb > 0) {
+            w->head += (size_t)nb;
+            continue;
+        }
+        if (nb == 0)
+            break;
+        int err = errno;
+        if (err == EINTR)
+            continue;
+        if (err == EAGAIN || err == EWOULDBLOCK)
+            break;
+        GPSUTILS_ERROR("Failed to write %zu bytes to fd: %d. Error: %s(%d)\n",
+                w->tail - w->head, w->fd, strerror(err), err);
+        // the rest of a partly written message is garbage to the device, so
+        // drop everything and let the hook stop waiting for writability
+        w->head = w->tail = 0;
+        if (w->hook)
+            w->hook(w->fd, false, w->hook_userdata);
+        return -1;
+    }
+    size_t pending = w->tail - w->head;
+    if (pending == 0) {
+        w->head = w->tail = 0;
+        if (w->hook)
+            w->hook(w->fd, false, w->hook_userdata);
+    } else {
+        GPSUTILS_DEBUG("%zu bytes left to write to fd: %d\n", pending, w->fd);
+    }
+    return (ssize_t)pending;
+}
+
+size_t gpsdevice_writer_pending(const gpsdevice_writer_t *w)
+{
+    return w ? (w->tail - w->head) : 0;
+}
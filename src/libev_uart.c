@@ -18,8 +18,52 @@ typedef struct {
     gpsdata_data_t *datalistp;
     int log_fd;
     char log_file[PATH_MAX];
+    gpsdata_binlog_writer_t *binlog;
+    char binlog_file[PATH_MAX];
+    // commands to the device are written when it is writable
+    struct ev_loop *loop;
+    ev_io write_watcher;
+    gpsdevice_writer_t *writer;
+    gpsdevice_cmdq_t *cmdq;
+    // resends or times out commands even if the device goes quiet
+    ev_timer cmdq_watcher;
 } mygps_t;
 
+void device_write_cb(EV_P_ ev_io *w, int revents)
+{
+    mygps_t *mydata = (mygps_t *)(w->data);
+    if (mydata && (revents & EV_WRITE)) {
+        // on error the writer drops its queue and the hook stops this watcher,
+        // the command queue resends whatever was lost
+        if (gpsdevice_writer_flush(mydata->writer) < 0) {
+            GPSUTILS_ERROR("Failed to write commands to device fd: %d\n", w->fd);
+        }
+    }
+}
+
+void device_writable_hook(int fd, bool want_writable, void *userdata)
+{
+    mygps_t *mydata = (mygps_t *)userdata;
+    if (want_writable) {
+        ev_io_start(mydata->loop, &(mydata->write_watcher));
+    } else {
+        ev_io_stop(mydata->loop, &(mydata->write_watcher));
+    }
+}
+
+void device_cmd_cb(uint16_t cmd, gpsdevice_cmd_status_t status, void *userdata)
+{
+    GPSUTILS_INFO("PMTK%03u completed with %s\n", cmd,
+            gpsdevice_cmd_status_tostring(status));
+}
+
+void cmdq_timer_cb(EV_P_ ev_timer *w, int revents)
+{
+    mygps_t *mydata = (mygps_t *)(w->data);
+    if (mydata)
+        gpsdevice_cmdq_poll(mydata->cmdq);
+}
+
 void device_io_cb(EV_P_ ev_io *w, int revents)
 {
     if (w && revents & EV_READ) {
@@ -47,6 +91,10 @@ void device_io_cb(EV_P_ ev_io *w, int revents)
                     }
                     gpsutils_timer_t timer;
                     size_t onum = 0;
+                    struct timespec rx = { 0 };
+                    clock_gettime(CLOCK_REALTIME, &rx);
+                    gpsdata_parser_set_rx_time(mydata->parser,
+                            (int64_t)rx.tv_sec * 1000000 + rx.tv_nsec / 1000);
                     gpsutils_timer_start(&timer);
                     int rc = gpsdata_parser_parse(mydata->parser, buf, nb,
                                                 &(mydata->datalistp), &onum);
@@ -62,6 +110,12 @@ void device_io_cb(EV_P_ ev_io *w, int revents)
                             GPSUTILS_INFO("Parsed %zu packets\n", onum);
                         }
                         gpsdata_list_dump(mydata->datalistp, GPSUTILS_LOG_PTR);
+                        if (mydata->binlog &&
+                            gpsdata_binlog_writer_append_list(mydata->binlog,
+                                    mydata->datalistp) < 0) {
+                            GPSUTILS_WARN("Failed to log fixes to %s\n",
+                                    mydata->binlog_file);
+                        }
                         // do more things here like add the data to a database
                         // free list here to save memory growth
                         gpsdata_list_free(&(mydata->datalistp));
@@ -91,7 +145,10 @@ int main(int argc, char **argv)
 #endif
     mygps_t mydata;
     memset(&mydata, 0, sizeof(mydata));
-    snprintf(mydata.log_file, sizeof(mydata.log_file) - 1, "/tmp/gps_%d.log", time(NULL));
+    // the raw and the binary log share the time stamp in their names
+    time_t started = time(NULL);
+    snprintf(mydata.log_file, sizeof(mydata.log_file) - 1, "/tmp/gps_%jd.log",
+            (intmax_t)started);
     // we log the data to a file for debugging
     mydata.log_fd = open(mydata.log_file, O_RDWR | O_CLOEXEC | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
     if (mydata.log_fd < 0) {
@@ -100,12 +157,24 @@ int main(int argc, char **argv)
         return -1;
     }
     GPSUTILS_INFO("Logging all received data to %s\n", mydata.log_file);
+    // the parsed fixes are logged in binary form for quick re-analysis
+    snprintf(mydata.binlog_file, sizeof(mydata.binlog_file) - 1, "/tmp/gps_%jd.bin",
+            (intmax_t)started);
+    mydata.binlog = gpsdata_binlog_writer_open(mydata.binlog_file, 0);
+    if (mydata.binlog) {
+        GPSUTILS_INFO("Logging parsed fixes to %s\n", mydata.binlog_file);
+    } else {
+        GPSUTILS_WARN("Not logging parsed fixes to %s\n", mydata.binlog_file);
+    }
     mydata.parser = gpsdata_parser_create();
     if (!mydata.parser) {
         GPSUTILS_ERROR("Failed to create gps parser\n");
+        gpsdata_binlog_writer_close(mydata.binlog);
         close(mydata.log_fd);
         return -1;
     }
+    // gpsdevice_open() sets the link to 9600 baud
+    gpsdata_parser_set_baudrate(mydata.parser, 9600);
 
     ev_io device_watcher = { 0 };
     ev_timer timeout_watcher = { 0 };
@@ -136,6 +205,26 @@ int main(int argc, char **argv)
         //set the data pointer so we can access the parser in the callback
         device_watcher.data = (void *)&mydata;
         ev_io_start(loop, &device_watcher);
+        mydata.loop = loop;
+        ev_io_init(&(mydata.write_watcher), device_write_cb, dev_fd, EV_WRITE);
+        mydata.write_watcher.data = (void *)&mydata;
+        mydata.writer = gpsdevice_writer_create(dev_fd, 0);
+        mydata.cmdq = gpsdevice_cmdq_create(dev_fd, 0,
+                            GPSDEVICE_CMDQ_DEFAULT_RETRIES, 0);
+        if (mydata.writer && mydata.cmdq) {
+            gpsdevice_writer_set_hook(mydata.writer, device_writable_hook, &mydata);
+            gpsdevice_cmdq_set_writer(mydata.cmdq, mydata.writer);
+            gpsdata_parser_set_ack_cb(mydata.parser, gpsdevice_cmdq_parser_ack,
+                    mydata.cmdq);
+            // poll at half the command timeout
+            ev_timer_init(&(mydata.cmdq_watcher), cmdq_timer_cb,
+                    GPSDEVICE_CMDQ_DEFAULT_TIMEOUT_MS / 2000.,
+                    GPSDEVICE_CMDQ_DEFAULT_TIMEOUT_MS / 2000.);
+            mydata.cmdq_watcher.data = (void *)&mydata;
+            ev_timer_start(loop, &(mydata.cmdq_watcher));
+            // confirm the fix interval that gpsdevice_open() set
+            gpsdevice_cmdq_submit(mydata.cmdq, "PMTK220,1000", device_cmd_cb, NULL);
+        }
 
         const char *no_timeout = getenv("NO_TIMEOUT");
         if (no_timeout) {
@@ -147,10 +236,14 @@ int main(int argc, char **argv)
         ev_run(loop, 0);
         rc = 0;
     }
+    gpsdata_parser_set_ack_cb(mydata.parser, NULL, NULL);
+    gpsdevice_cmdq_free(mydata.cmdq);
+    gpsdevice_writer_free(mydata.writer);
     gpsdevice_close(dev_fd);
     // free memory
     gpsdata_parser_free(mydata.parser);
     gpsdata_list_free(&(mydata.datalistp));
+    gpsdata_binlog_writer_close(mydata.binlog);
     close(mydata.log_fd);
     return rc;
 }
@@ -0,0 +1,181 @@
+/*
+ * Copyright: 2015-2020. Stealthy Labs LLC. All Rights Reserved.
+ * Date: 17th October 2026
+ * Software: libgps_mtk3339
+ */
+#include <gpsconfig.h>
+#include <gpsdata.h>
+#ifdef LIBGPS_MTK3339_HAVE_FCNTL_H
+    #include <fcntl.h>
+#endif
+
+/* writes a synthetic NMEA stream of the requested size to a file or stdout */
+
+#define NMEAGEN_BUFSIZE (64 * 1024)
+
+static void nmeagen_usage(const char *app)
+{
+    fprintf(stderr,
+        "Usage: %s [OPTIONS]\n"
+        "  -n <bytes>       size of the stream. suffixes k, m and g are allowed. default 1m\n"
+        "  -o <file>        write to file instead of stdout\n"
+        "  -s <seed>        seed of the stream. default 3339\n"
+        "  -r <ms>          fix interval in milliseconds. default 1000\n"
+        "  -m <list>        sentences of each fix, a comma separated list of\n"
+        "                   GGA,RMC,GLL,VTG,GSA. default GGA,RMC,VTG,GSA\n"
+        "  -g <N>           a GPGSV group every N fixes, 0 for none. default 5\n"
+        "  -t <N>           a PGTOP status every N fixes, 0 for none. default 10\n"
+        "  -f <N>           a PMTK705 response every N fixes, 0 for none. default 0\n"
+        "  -v <m/s>         mean speed. default 5\n"
+        "  -b <rate>        probability of a bit flip per sentence\n"
+        "  -x <rate>        probability of a truncated sentence\n"
+        "  -c <rate>        probability of a bad checksum per sentence\n"
+        "  -h               this help message\n", app);
+}
+
+static int nmeagen_parse_size(const char *arg, uint64_t *size)
+{
+    char *end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(arg, &end, 10);
+    if (errno != 0 || end == arg)
+        return -1;
+    switch (tolower((unsigned char)*end)) {
+    case 'g': v <<= 10; // fallthrough
+    case 'm': v <<= 10; // fallthrough
+    case 'k': v <<= 10; end++; break;
+    case '\0': break;
+    default: return -1;
+    }
+    if (*end != '\0')
+        return -1;
+    *size = v;
+    return 0;
+}
+
+static int nmeagen_parse_mask(const char *arg, uint32_t *mask)
+{
+    static const struct {
+        const char *name;
+        gpsdata_msgid_t msgid;
+    } names[] = {
+        { "GGA", GPSDATA_MSGID_GPGGA },
+        { "RMC", GPSDATA_MSGID_GPRMC },
+        { "GLL", GPSDATA_MSGID_GPGLL },
+        { "VTG", GPSDATA_MSGID_GPVTG },
+        { "GSA", GPSDATA_MSGID_GPGSA }
+    };
+    *mask = 0;
+    const char *p = arg;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        bool found = false;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+            if (len == strlen(names[i].name) && strncasecmp(p, names[i].name, len) == 0) {
+                *mask |= GPSDATA_MSGID_MASK(names[i].msgid);
+                found = true;
+            }
+        }
+        if (!found)
+            return -1;
+        p += len;
+        if (*p == ',')
+            p++;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    gpsdata_generator_config_t config;
+    gpsdata_generator_config_default(&config);
+    uint64_t size = 1024 * 1024;
+    const char *outfile = NULL;
+    int opt;
+    int rc = 0;
+    while ((opt = getopt(argc, argv, "n:o:s:r:m:g:t:f:v:b:x:c:h")) != -1) {
+        switch (opt) {
+        case 'n': rc = nmeagen_parse_size(optarg, &size); break;
+        case 'o': outfile = optarg; break;
+        case 's': config.seed = strtoull(optarg, NULL, 0); break;
+        case 'r': config.fix_interval_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'm': rc = nmeagen_parse_mask(optarg, &config.msgid_mask); break;
+        case 'g': config.gsv_every = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 't': config.pgtop_every = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'f': config.pmtk_every = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'v': config.speed_mps = strtof(optarg, NULL); break;
+        case 'b': config.bitflip_rate = strtod(optarg, NULL); break;
+        case 'x': config.truncate_rate = strtod(optarg, NULL); break;
+        case 'c': config.bad_checksum_rate = strtod(optarg, NULL); break;
+        case 'h':
+            nmeagen_usage(argv[0]);
+            return 0;
+        default:
+            nmeagen_usage(argv[0]);
+            return 1;
+        }
+        if (rc < 0) {
+            fprintf(stderr, "Invalid value for -%c: %s\n", opt, optarg);
+            nmeagen_usage(argv[0]);
+            return 1;
+        }
+    }
+    gpsdata_generator_t *gen = gpsdata_generator_create(&config);
+    if (!gen) {
+        GPSUTILS_ERROR("Invalid generator settings\n");
+        return 1;
+    }
+    int fd = STDOUT_FILENO;
+    if (outfile) {
+        fd = open(outfile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            int err = errno;
+            GPSUTILS_ERROR("Unable to open %s. Error: %s(%d)\n", outfile,
+                    strerror(err), err);
+            gpsdata_generator_free(gen);
+            return 1;
+        }
+    }
+    char *buf = malloc(NMEAGEN_BUFSIZE);
+    if (!buf) {
+        GPSUTILS_ERROR_NOMEM(NMEAGEN_BUFSIZE);
+        rc = -1;
+    }
+    uint64_t written = 0;
+    while (rc == 0 && written < size) {
+        size_t len = NMEAGEN_BUFSIZE;
+        if (size - written < len)
+            len = (size_t)(size - written);
+        ssize_t nb = gpsdata_generator_fill(gen, buf, len);
+        if (nb <= 0) {
+            rc = -1;
+            break;
+        }
+        for (ssize_t off = 0; off < nb; ) {
+            ssize_t w = write(fd, buf + off, (size_t)(nb - off));
+            if (w < 0) {
+                int err = errno;
+                if (err == EINTR)
+                    continue;
+                GPSUTILS_ERROR("Failed to write the stream. Error: %s(%d)\n",
+                        strerror(err), err);
+                rc = -1;
+                break;
+            }
+            off += w;
+        }
+        written += (uint64_t)nb;
+    }
+    gpsdata_generator_stats_t stats;
+    if (gpsdata_generator_get_stats(gen, &stats) == 0) {
+        fprintf(stderr, "%" PRIu64 " fixes, %" PRIu64 " sentences, %" PRIu64
+                " bytes, %" PRIu64 " bit flips, %" PRIu64 " truncations, %" PRIu64
+                " bad checksums\n", stats.fixes, stats.sentences, stats.bytes,
+                stats.bitflips, stats.truncations, stats.bad_checksums);
+    }
+    GPSUTILS_FREE(buf);
+    if (outfile)
+        close(fd);
+    gpsdata_generator_free(gen);
+    return (rc < 0) ? 1 : 0;
+}
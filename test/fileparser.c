@@ -8,6 +8,13 @@
 #ifdef LIBGPS_MTK3339_HAVE_FCNTL_H
     #include <fcntl.h>
 #endif
+#ifdef LIBGPS_MTK3339_HAVE_SYS_STAT_H
+    #include <sys/stat.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_SYS_RESOURCE_H
+    #include <sys/resource.h>
+    #include <signal.h>
+#endif
 #ifdef LIBGPS_MTK3339_HAVE_CUNIT
     #include <CUnit/CUnit.h>
     #include <CUnit/Basic.h>
@@ -68,6 +75,366 @@ void test_parse_file()
     }
 }
 
+void test_parse_file_list()
+{
+    gpsutils_timer_t tt;
+    CU_ASSERT_PTR_NOT_NULL(g_filelist);
+    if (!g_filelist) {
+        GPSUTILS_ERROR("Filename list is NULL\n");
+        return;
+    }
+    filename_t *el = NULL;
+    LL_FOREACH(g_filelist, el) {
+        CU_ASSERT_PTR_NOT_NULL(el);
+        CU_ASSERT_PTR_NOT_NULL(el->name);
+        if (!el->name)
+            continue;
+        FILE *fp = fopen(el->name, "rb");
+        CU_ASSERT_PTR_NOT_NULL(fp);
+        gpsdata_parser_t *fsm = gpsdata_parser_create();
+        CU_ASSERT_PTR_NOT_NULL(fsm);
+        char buf[256];
+        gpsdata_list_t outl;
+        gpsdata_list_init(&outl);
+        gpsutils_timer_start(&tt);
+        while (!feof(fp)) {
+            size_t nb = fread(buf, sizeof(char), sizeof(buf) / sizeof(char), fp);
+            if (nb > 0) {
+                size_t onum = 0;
+                int rc = gpsdata_parser_parse_list(fsm, buf, nb, &outl, &onum);
+                CU_ASSERT(rc >= 0);
+                gpsdata_parser_dump_state(fsm, stdout);
+                memset(buf, 0, sizeof(buf) / sizeof(char));
+                if (rc < 0)
+                    break;
+            } else {
+                GPSUTILS_WARN("Looks like end of file reached\n");
+                break;
+            }
+        }
+        gpsutils_timer_stop(&tt);
+        GPSUTILS_INFO("Time taken to parse input file %s: %lfs\n", el->name, tt.time_taken);
+        CU_ASSERT_PTR_NOT_NULL(outl.head);
+        CU_ASSERT_EQUAL((ssize_t)outl.count, gpsdata_list_count(outl.head));
+        GPSUTILS_INFO("No. of objects in file: %zu\n", outl.count);
+        gpsdata_list_dump(outl.head, stdout);
+        gpsdata_list_clear(&outl);
+
+        fclose(fp);
+        gpsdata_parser_free(fsm);
+    }
+}
+
+void test_parse_file_parallel()
+{
+    gpsutils_timer_t tt;
+    CU_ASSERT_PTR_NOT_NULL(g_filelist);
+    if (!g_filelist) {
+        GPSUTILS_ERROR("Filename list is NULL\n");
+        return;
+    }
+    filename_t *el = NULL;
+    LL_FOREACH(g_filelist, el) {
+        if (!el->name)
+            continue;
+        // the sequential parse is the reference
+        FILE *fp = fopen(el->name, "rb");
+        CU_ASSERT_PTR_NOT_NULL(fp);
+        if (!fp)
+            continue;
+        gpsdata_parser_t *fsm = gpsdata_parser_create();
+        CU_ASSERT_PTR_NOT_NULL(fsm);
+        // some files start or end in the middle of a message, which the
+        // parallel parsers skip as well
+        CU_ASSERT_EQUAL(gpsdata_parser_set_resync(fsm, true), 0);
+        char buf[256];
+        gpsdata_list_t seql;
+        gpsdata_list_init(&seql);
+        size_t seq_errors = 0;
+        gpsutils_timer_start(&tt);
+        while (!feof(fp)) {
+            size_t nb = fread(buf, sizeof(char), sizeof(buf) / sizeof(char), fp);
+            if (nb == 0)
+                break;
+            int rc = gpsdata_parser_parse_list(fsm, buf, nb, &seql, NULL);
+            CU_ASSERT(rc >= 0);
+            if (rc < 0)
+                break;
+            seq_errors += (size_t)rc;
+        }
+        gpsutils_timer_stop(&tt);
+        GPSUTILS_INFO("Time taken to parse input file %s sequentially with %zu errors: %lfs\n",
+                el->name, seq_errors, tt.time_taken);
+        fclose(fp);
+        gpsdata_parser_free(fsm);
+        CU_ASSERT(seql.count > 0);
+
+        for (size_t nthreads = 1; nthreads <= 8; nthreads *= 2) {
+            gpsdata_list_t parl;
+            gpsdata_list_init(&parl);
+            size_t onum = 0;
+            gpsutils_timer_start(&tt);
+            int rc = gpsdata_parse_file_parallel(el->name, nthreads, &parl, &onum);
+            gpsutils_timer_stop(&tt);
+            GPSUTILS_INFO("Time taken to parse input file %s with %zu threads and %d errors: %lfs\n",
+                    el->name, nthreads, rc, tt.time_taken);
+            CU_ASSERT(rc >= 0);
+            CU_ASSERT_EQUAL(onum, parl.count);
+            CU_ASSERT_EQUAL(parl.count, seql.count);
+            size_t compared = 0;
+            const gpsdata_data_t *a = seql.head;
+            const gpsdata_data_t *b = parl.head;
+            for (; a && b; a = a->next, b = b->next, ++compared) {
+                CU_ASSERT_EQUAL(a->msgid, b->msgid);
+                CU_ASSERT_EQUAL(a->is_valid_timestamp, b->is_valid_timestamp);
+                CU_ASSERT_EQUAL(a->timestamp.tv_sec, b->timestamp.tv_sec);
+                CU_ASSERT_EQUAL(a->timestamp.tv_usec, b->timestamp.tv_usec);
+                CU_ASSERT_EQUAL(a->latitude.direction, b->latitude.direction);
+                CU_ASSERT_EQUAL(a->latitude.degrees, b->latitude.degrees);
+                CU_ASSERT_EQUAL(a->longitude.degrees, b->longitude.degrees);
+            }
+            CU_ASSERT_PTR_NULL(a);
+            CU_ASSERT_PTR_NULL(b);
+            CU_ASSERT_EQUAL(compared, seql.count);
+            gpsdata_list_clear(&parl);
+        }
+        gpsdata_list_clear(&seql);
+    }
+}
+
+void test_binlog()
+{
+    CU_ASSERT_PTR_NOT_NULL(g_filelist);
+    if (!g_filelist)
+        return;
+    filename_t *el = NULL;
+    LL_FOREACH(g_filelist, el) {
+        if (!el->name)
+            continue;
+        gpsdata_list_t list;
+        gpsdata_list_init(&list);
+        if (gpsdata_parse_file_parallel(el->name, 1, &list, NULL) < 0 || !list.head) {
+            gpsdata_list_clear(&list);
+            continue;
+        }
+        char path[] = "/tmp/test_binlog_XXXXXX";
+        int fd = mkstemp(path);
+        CU_ASSERT(fd >= 0);
+        if (fd < 0) {
+            gpsdata_list_clear(&list);
+            continue;
+        }
+        close(fd);
+        // a small batch makes the writer flush several times
+        gpsdata_binlog_writer_t *w = gpsdata_binlog_writer_open(path, 7);
+        CU_ASSERT_PTR_NOT_NULL(w);
+        CU_ASSERT_EQUAL(gpsdata_binlog_writer_append_list(w, list.head), 0);
+        CU_ASSERT_EQUAL(gpsdata_binlog_writer_close(w), 0);
+        // appending to the existing file keeps the earlier records
+        w = gpsdata_binlog_writer_open(path, 0);
+        CU_ASSERT_PTR_NOT_NULL(w);
+        CU_ASSERT_EQUAL(gpsdata_binlog_writer_append_list(w, list.head), 0);
+        CU_ASSERT_EQUAL(gpsdata_binlog_writer_close(w), 0);
+
+        gpsdata_binlog_reader_t *r = gpsdata_binlog_reader_open(path);
+        CU_ASSERT_PTR_NOT_NULL(r);
+        size_t count = 0;
+        const gpsdata_binlog_record_t *recs = gpsdata_binlog_reader_records(r, &count);
+        CU_ASSERT_EQUAL(count, 2 * list.count);
+        const gpsdata_data_t *item = list.head;
+        for (size_t i = 0; recs && i < count && item; ++i) {
+            gpsdata_fix_t fix;
+            gpsdata_binlog_record_t expect;
+            gpsdata_fix_from_data(&fix, item);
+            gpsdata_binlog_record_from_fix(&expect, &fix);
+            CU_ASSERT_EQUAL(memcmp(&recs[i], &expect, sizeof(expect)), 0);
+            item = item->next ? item->next : list.head;
+        }
+        if (count > 0) {
+            gpsdata_fix_t fix;
+            gpsdata_fix_from_data(&fix, list.head);
+            gpsdata_fix_t back;
+            gpsdata_binlog_record_to_fix(&recs[0], &back);
+            CU_ASSERT_EQUAL(back.timestamp_usec, fix.timestamp_usec);
+            CU_ASSERT_EQUAL(back.latitude_e7, fix.latitude_e7);
+            CU_ASSERT_EQUAL(back.longitude_e7, fix.longitude_e7);
+            CU_ASSERT_EQUAL(back.msgid, fix.msgid);
+        }
+        gpsdata_binlog_reader_close(r);
+        unlink(path);
+        gpsdata_list_clear(&list);
+    }
+}
+
+void test_binlog_short_write()
+{
+#ifdef LIBGPS_MTK3339_HAVE_SYS_RESOURCE_H
+    char path[] = "/tmp/test_binlog_XXXXXX";
+    int fd = mkstemp(path);
+    CU_ASSERT(fd >= 0);
+    if (fd < 0)
+        return;
+    close(fd);
+    gpsdata_fix_t fixes[5];
+    memset(fixes, 0, sizeof(fixes));
+    for (size_t i = 0; i < 5; ++i) {
+        fixes[i].timestamp_usec = (int64_t)(i + 1) * 1000000;
+        fixes[i].latitude_e7 = GPSDATA_FIXED_UNSET;
+        fixes[i].longitude_e7 = GPSDATA_FIXED_UNSET;
+        fixes[i].altitude_mm = GPSDATA_FIXED_UNSET;
+        fixes[i].speed_mmps = GPSDATA_FIXED_UNSET;
+        fixes[i].course_degrees = NAN;
+        fixes[i].hdop = NAN;
+        fixes[i].msgid = GPSDATA_MSGID_GPRMC;
+    }
+    gpsdata_binlog_writer_t *w = gpsdata_binlog_writer_open(path, 2);
+    CU_ASSERT_PTR_NOT_NULL(w);
+    if (!w) {
+        unlink(path);
+        return;
+    }
+    CU_ASSERT_EQUAL(gpsdata_binlog_writer_append(w, &fixes[0]), 0);
+    CU_ASSERT_EQUAL(gpsdata_binlog_writer_append(w, &fixes[1]), 0);
+    off_t good = (off_t)(sizeof(gpsdata_binlog_header_t) +
+                    2 * sizeof(gpsdata_binlog_record_t));
+    struct stat st;
+    CU_ASSERT_EQUAL(stat(path, &st), 0);
+    CU_ASSERT_EQUAL(st.st_size, good);
+
+    // the file size limit lets the next batch in only partly
+    struct rlimit old_rl, rl;
+    CU_ASSERT_EQUAL(getrlimit(RLIMIT_FSIZE, &old_rl), 0);
+    void (*old_sig)(int) = signal(SIGXFSZ, SIG_IGN);
+    rl = old_rl;
+    rl.rlim_cur = (rlim_t)good + sizeof(gpsdata_binlog_record_t) + 8;
+    CU_ASSERT_EQUAL(setrlimit(RLIMIT_FSIZE, &rl), 0);
+    CU_ASSERT_EQUAL(gpsdata_binlog_writer_append(w, &fixes[2]), 0);
+    CU_ASSERT_EQUAL(gpsdata_binlog_writer_append(w, &fixes[3]), 0);
+    int rc_full = gpsdata_binlog_writer_append(w, &fixes[4]);
+    int rc_flush = gpsdata_binlog_writer_flush(w);
+    int rc_stat = stat(path, &st);
+    setrlimit(RLIMIT_FSIZE, &old_rl);
+    signal(SIGXFSZ, old_sig);
+    // the kept batch has no room and the partial write was cut off
+    CU_ASSERT_EQUAL(rc_full, -1);
+    CU_ASSERT_EQUAL(rc_flush, -1);
+    CU_ASSERT_EQUAL(rc_stat, 0);
+    CU_ASSERT_EQUAL(st.st_size, good);
+
+    // the kept batch goes out once the file can grow again
+    CU_ASSERT_EQUAL(gpsdata_binlog_writer_append(w, &fixes[4]), 0);
+    CU_ASSERT_EQUAL(gpsdata_binlog_writer_close(w), 0);
+    gpsdata_binlog_reader_t *r = gpsdata_binlog_reader_open(path);
+    CU_ASSERT_PTR_NOT_NULL(r);
+    size_t count = 0;
+    const gpsdata_binlog_record_t *recs = gpsdata_binlog_reader_records(r, &count);
+    CU_ASSERT_EQUAL(count, 5);
+    for (size_t i = 0; recs && i < count; ++i) {
+        CU_ASSERT_EQUAL(recs[i].timestamp_usec, fixes[i].timestamp_usec);
+    }
+    gpsdata_binlog_reader_close(r);
+    unlink(path);
+#endif
+}
+
+void test_codec()
+{
+    CU_ASSERT_PTR_NOT_NULL(g_filelist);
+    if (!g_filelist)
+        return;
+    filename_t *el = NULL;
+    LL_FOREACH(g_filelist, el) {
+        if (!el->name)
+            continue;
+        gpsdata_list_t list;
+        gpsdata_list_init(&list);
+        if (gpsdata_parse_file_parallel(el->name, 1, &list, NULL) < 0 || !list.head) {
+            gpsdata_list_clear(&list);
+            continue;
+        }
+        size_t cap = list.count * GPSDATA_CODEC_MAX_RECORD;
+        uint8_t *buf = calloc(1, cap);
+        size_t *restarts = calloc(list.count, sizeof(*restarts));
+        CU_ASSERT_PTR_NOT_NULL(buf);
+        CU_ASSERT_PTR_NOT_NULL(restarts);
+        if (!buf || !restarts) {
+            GPSUTILS_FREE(buf);
+            GPSUTILS_FREE(restarts);
+            gpsdata_list_clear(&list);
+            continue;
+        }
+        gpsdata_codec_t codec;
+        gpsdata_codec_init(&codec, 16);
+        size_t len = 0;
+        size_t nrestarts = 0;
+        const gpsdata_data_t *item = NULL;
+        LL_FOREACH(list.head, item) {
+            gpsdata_fix_t fix;
+            bool restart = false;
+            gpsdata_fix_from_data(&fix, item);
+            int rc = gpsdata_codec_encode(&codec, &fix, buf + len, cap - len, &restart);
+            CU_ASSERT(rc > 0);
+            if (rc <= 0)
+                break;
+            if (restart)
+                restarts[nrestarts++] = len;
+            len += (size_t)rc;
+        }
+        CU_ASSERT_EQUAL(nrestarts, (list.count + 15) / 16);
+        // the encoded stream is smaller than the fixes it holds
+        CU_ASSERT(len < list.count * sizeof(gpsdata_fix_t));
+
+        gpsdata_codec_init(&codec, 16);
+        size_t off = 0;
+        size_t idx = 0;
+        LL_FOREACH(list.head, item) {
+            gpsdata_fix_t fix, back;
+            gpsdata_fix_from_data(&fix, item);
+            // a truncated record is reported as incomplete
+            CU_ASSERT_EQUAL(gpsdata_codec_decode(&codec, buf + off, 0, &back), 0);
+            int rc = gpsdata_codec_decode(&codec, buf + off, len - off, &back);
+            CU_ASSERT(rc > 0);
+            if (rc <= 0)
+                break;
+            off += (size_t)rc;
+            CU_ASSERT_EQUAL(back.timestamp_usec, fix.timestamp_usec);
+            CU_ASSERT_EQUAL(back.latitude_e7, fix.latitude_e7);
+            CU_ASSERT_EQUAL(back.longitude_e7, fix.longitude_e7);
+            CU_ASSERT_EQUAL(back.altitude_mm, fix.altitude_mm);
+            CU_ASSERT_EQUAL(back.speed_mmps, fix.speed_mmps);
+            CU_ASSERT_EQUAL(back.msgid, fix.msgid);
+            CU_ASSERT_EQUAL(back.num_satellites, fix.num_satellites);
+            idx++;
+        }
+        CU_ASSERT_EQUAL(off, len);
+        CU_ASSERT_EQUAL(idx, list.count);
+        // decoding from the last restart point gives the same fixes
+        if (nrestarts > 0) {
+            size_t skip = (nrestarts - 1) * 16;
+            item = list.head;
+            for (size_t i = 0; i < skip && item; ++i)
+                item = item->next;
+            gpsdata_codec_init(&codec, 16);
+            off = restarts[nrestarts - 1];
+            for (; item; item = item->next) {
+                gpsdata_fix_t fix, back;
+                gpsdata_fix_from_data(&fix, item);
+                int rc = gpsdata_codec_decode(&codec, buf + off, len - off, &back);
+                CU_ASSERT(rc > 0);
+                if (rc <= 0)
+                    break;
+                off += (size_t)rc;
+                CU_ASSERT_EQUAL(back.timestamp_usec, fix.timestamp_usec);
+                CU_ASSERT_EQUAL(back.latitude_e7, fix.latitude_e7);
+            }
+            CU_ASSERT_EQUAL(off, len);
+        }
+        GPSUTILS_FREE(buf);
+        GPSUTILS_FREE(restarts);
+        gpsdata_list_clear(&list);
+    }
+}
+
 int main(int argc, char **argv)
 {
     int err = 0;
@@ -123,11 +490,21 @@ int main(int argc, char **argv)
         size_t count = 0;
         filename_t *el = NULL, *el_tmp = NULL;
         LL_COUNT(g_filelist, el, count);
+        if (!CU_ADD_TEST(suite, test_binlog_short_write))
+            break;
         if (count == 0) {
             GPSUTILS_WARN("No files found for testing, skipping tests\n");
         } else {
             if (!CU_ADD_TEST(suite, test_parse_file))
                 break;
+            if (!CU_ADD_TEST(suite, test_parse_file_list))
+                break;
+            if (!CU_ADD_TEST(suite, test_parse_file_parallel))
+                break;
+            if (!CU_ADD_TEST(suite, test_binlog))
+                break;
+            if (!CU_ADD_TEST(suite, test_codec))
+                break;
         }
         /* set the mode of the test run in
          * debug/release mode*/
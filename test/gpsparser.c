@@ -8,6 +8,14 @@
 #ifdef LIBGPS_MTK3339_HAVE_FCNTL_H
     #include <fcntl.h>
 #endif
+#include <signal.h>
+#ifdef LIBGPS_MTK3339_HAVE_PTHREAD_H
+    #include <pthread.h>
+#endif
+#ifdef LIBGPS_MTK3339_HAVE_PTY_H
+    #include <pty.h>
+    #include <stdatomic.h>
+#endif
 #ifdef LIBGPS_MTK3339_HAVE_CUNIT
     #include <CUnit/CUnit.h>
     #include <CUnit/Basic.h>
@@ -182,6 +190,31 @@ void test_parse_gpgsa()
     GPSUTILS_FREE(gpgsa_1);
     GPSUTILS_FREE(gpgsa_2);
     gpsdata_parser_free(fsm);
+
+    // the message is saved once the line ends
+    const char *gpgsa_nl =
+        "$GPGSA,A,3,29,21,26,15,18,09,06,10,,,,,2.32,0.95,2.11*00\r\n";
+    gpsdata_list_t list;
+    gpsdata_list_init(&list);
+    fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    rc = gpsdata_parser_parse_list(fsm, gpgsa_nl, strlen(gpgsa_nl), &list, &onum);
+    CU_ASSERT(rc >= 0);
+    CU_ASSERT_EQUAL(onum, 1);
+    if (onum == 1) {
+        const gpsdata_data_t *item = list.head;
+        const uint8_t used[] = { 29, 21, 26, 15, 18, 9, 6, 10 };
+        CU_ASSERT_EQUAL(item->msgid, GPSDATA_MSGID_GPGSA);
+        CU_ASSERT_EQUAL(item->gsa.selection, GPSDATA_MODE_AUTOMATIC);
+        CU_ASSERT_EQUAL(item->gsa.fix, GPSDATA_MODE_3DFIX);
+        CU_ASSERT_EQUAL(item->gsa.num_used, sizeof(used));
+        CU_ASSERT_EQUAL(memcmp(item->gsa.satellites_used, used, sizeof(used)), 0);
+        CU_ASSERT_DOUBLE_EQUAL(item->dop.pdop, 2.32, 0.001);
+        CU_ASSERT_DOUBLE_EQUAL(item->dop.hdop, 0.95, 0.001);
+        CU_ASSERT_DOUBLE_EQUAL(item->dop.vdop, 2.11, 0.001);
+    }
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
 }
 
 void test_parse_gpgsv()
@@ -208,6 +241,21 @@ void test_parse_gpgsv()
     CU_ASSERT(rc >= 0);
     CU_ASSERT_EQUAL(onum, 0);
     CU_ASSERT_PTR_NULL(outp);
+    gpsdata_skyview_t sv;
+    CU_ASSERT_EQUAL(gpsdata_parser_get_skyview(fsm, &sv), 0);
+    CU_ASSERT_EQUAL(sv.seq, 1);
+    CU_ASSERT_EQUAL(sv.groups_dropped, 0);
+    CU_ASSERT_EQUAL(sv.num_in_view, 9);
+    CU_ASSERT_EQUAL(sv.num_sats, 9);
+    CU_ASSERT_EQUAL(sv.sats[0].satellite_id, 29);
+    CU_ASSERT_EQUAL(sv.sats[0].elevation, 36);
+    CU_ASSERT_EQUAL(sv.sats[0].azimuth, 29);
+    CU_ASSERT_EQUAL(sv.sats[0].snr_cno, 42);
+    CU_ASSERT_EQUAL(sv.sats[0].null_mask, 0);
+    CU_ASSERT_EQUAL(sv.sats[8].satellite_id, 7);
+    CU_ASSERT_EQUAL(sv.sats[8].snr_cno, 26);
+    CU_ASSERT_EQUAL(sv.sats[8].null_mask,
+            GPSDATA_SKYVIEW_NULL_ELEVATION | GPSDATA_SKYVIEW_NULL_AZIMUTH);
 
     GPSUTILS_INFO("\n\nInput buffer: %s\n\n", gpgsv1);
     gpsutils_timer_start(&tt);
@@ -218,6 +266,26 @@ void test_parse_gpgsv()
     CU_ASSERT(rc >= 0);
     CU_ASSERT_EQUAL(onum, 0);
     CU_ASSERT_PTR_NULL(outp);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_skyview(fsm, &sv), 0);
+    CU_ASSERT_EQUAL(sv.seq, 2);
+    CU_ASSERT_EQUAL(sv.num_sats, 7);
+    CU_ASSERT_EQUAL(sv.sats[6].satellite_id, 41);
+    CU_ASSERT_EQUAL(sv.sats[6].null_mask, GPSDATA_SKYVIEW_NULL_ELEVATION |
+            GPSDATA_SKYVIEW_NULL_AZIMUTH | GPSDATA_SKYVIEW_NULL_SNR);
+
+    // the second message of the first group is lost, so only the third
+    // group is published
+    const char *gpgsv_lost =
+        "$GPGSV,2,1,07,21,67,278,18,15,66,048,38,20,46,302,26,24,38,154,13*72\r\n"
+        "$GPGSV,2,1,07,21,67,278,18,15,66,048,38,20,46,302,26,24,38,154,13*72\r\n"
+        "$GPGSV,2,2,07,13,33,048,22,10,19,289,17,41,,,*79\r\n"
+        "$GPGSV,2,2,07,13,33,048,22,10,19,289,17,41,,,*79\r\n";
+    rc = gpsdata_parser_parse(fsm, gpgsv_lost, strlen(gpgsv_lost), &outp, &onum);
+    CU_ASSERT(rc >= 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_skyview(fsm, &sv), 0);
+    CU_ASSERT_EQUAL(sv.seq, 3);
+    CU_ASSERT_EQUAL(sv.groups_dropped, 2);
+    CU_ASSERT_EQUAL(sv.num_sats, 7);
 
     gpsdata_parser_free(fsm);
 }
@@ -280,6 +348,1248 @@ void test_parse_gpvtg()
     gpsdata_parser_free(fsm);
 }
 
+void test_parse_pool()
+{
+    const char *gprmc =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\n";
+    int rc = 0;
+    size_t gprmc_len = strlen(gprmc);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_pool_capacity(fsm, 4), 0);
+
+    gpsdata_pool_stats_t stats = { 0 };
+    gpsdata_data_t *outp = NULL;
+    size_t onum = 0;
+    for (int i = 0; i < 100; ++i) {
+        rc = gpsdata_parser_parse(fsm, gprmc, gprmc_len, &outp, &onum);
+        CU_ASSERT(rc >= 0);
+        CU_ASSERT_EQUAL(onum, 1);
+        CU_ASSERT_PTR_NOT_NULL(outp);
+        gpsdata_list_free(&outp);
+    }
+    CU_ASSERT_EQUAL(gpsdata_parser_get_pool_stats(fsm, &stats), 0);
+    GPSUTILS_INFO("Pool hits: %" PRIu64 " misses: %" PRIu64 " capacity: %zu\n",
+            stats.hits, stats.misses, stats.capacity);
+    // steady state parsing should never grow the pool
+    CU_ASSERT_EQUAL(stats.hits, 100);
+    CU_ASSERT_EQUAL(stats.misses, 0);
+    CU_ASSERT_EQUAL(stats.capacity, 4);
+    CU_ASSERT_EQUAL(stats.available, 4);
+
+    // holding on to more items than the capacity grows the pool
+    for (int i = 0; i < 6; ++i) {
+        rc = gpsdata_parser_parse(fsm, gprmc, gprmc_len, &outp, &onum);
+        CU_ASSERT(rc >= 0);
+    }
+    CU_ASSERT_EQUAL(gpsdata_list_count(outp), 6);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_pool_stats(fsm, &stats), 0);
+    CU_ASSERT_EQUAL(stats.misses, 1);
+    CU_ASSERT_EQUAL(stats.capacity, 8);
+    CU_ASSERT_EQUAL(stats.available, 2);
+    // the list outlives the parser and is still valid
+    gpsdata_parser_free(fsm);
+    gpsdata_list_dump(outp, stdout);
+    gpsdata_list_free(&outp);
+}
+
+void test_parse_list()
+{
+    const char *gpvtg = "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\n";
+    size_t gpvtg_len = strlen(gpvtg);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+
+    gpsdata_list_t outl;
+    gpsdata_list_init(&outl);
+    size_t onum = 0;
+    for (int i = 0; i < 10; ++i) {
+        int rc = gpsdata_parser_parse_list(fsm, gpvtg, gpvtg_len, &outl, &onum);
+        CU_ASSERT(rc >= 0);
+        CU_ASSERT_EQUAL(onum, 1);
+        CU_ASSERT_EQUAL(outl.count, (size_t)(i + 1));
+    }
+    CU_ASSERT_EQUAL(gpsdata_list_count(outl.head), 10);
+    CU_ASSERT_PTR_NULL(outl.tail->next);
+    // an incomplete message adds nothing and resets onum
+    int rc = gpsdata_parser_parse_list(fsm, gpvtg, 10, &outl, &onum);
+    CU_ASSERT(rc >= 0);
+    CU_ASSERT_EQUAL(onum, 0);
+    CU_ASSERT_EQUAL(outl.count, 10);
+
+    gpsdata_list_t other;
+    gpsdata_list_init(&other);
+    gpsdata_list_concat(&other, &outl);
+    CU_ASSERT_EQUAL(other.count, 10);
+    CU_ASSERT_EQUAL(outl.count, 0);
+    CU_ASSERT_PTR_NULL(outl.head);
+    CU_ASSERT_PTR_NULL(outl.tail);
+    gpsdata_list_clear(&other);
+    CU_ASSERT_PTR_NULL(other.head);
+    CU_ASSERT_EQUAL(other.count, 0);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_columns()
+{
+    const char *buf =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n"
+        "$PGTOP,11,3*6F\r\n";
+    size_t buflen = strlen(buf);
+    int64_t ts[3];
+    double lat[3], lon[3];
+    float alt[3], speed[3];
+    uint8_t msgid[3], nsats[3];
+    gpsdata_columns_t cols;
+    memset(&cols, 0, sizeof(cols));
+    cols.capacity = 3;
+    cols.timestamp_usec = ts;
+    cols.latitude = lat;
+    cols.longitude = lon;
+    cols.altitude_meters = alt;
+    cols.speed_knots = speed;
+    cols.msgid = msgid;
+    cols.num_satellites = nsats;
+
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    size_t consumed = 0;
+    int rc = gpsdata_parser_parse_columns(fsm, buf, buflen, &cols, &consumed);
+    CU_ASSERT_EQUAL(rc, 3);
+    CU_ASSERT_EQUAL(cols.count, 3);
+    CU_ASSERT(consumed > 0 && consumed < buflen);
+    CU_ASSERT_EQUAL(msgid[0], GPSDATA_MSGID_GPRMC);
+    CU_ASSERT_EQUAL(msgid[1], GPSDATA_MSGID_GPGGA);
+    CU_ASSERT_EQUAL(msgid[2], GPSDATA_MSGID_GPVTG);
+    // 26th April 2006 06:49:51 UTC
+    CU_ASSERT_EQUAL(ts[0], INT64_C(1146034191000000));
+    CU_ASSERT_DOUBLE_EQUAL(lat[0], 23.118760, 1e-5);
+    CU_ASSERT_DOUBLE_EQUAL(lon[0], 120.274063, 1e-5);
+    CU_ASSERT_DOUBLE_EQUAL(speed[0], 0.03, 1e-5);
+    CU_ASSERT_DOUBLE_EQUAL(lat[1], 40.809988, 1e-5);
+    CU_ASSERT_DOUBLE_EQUAL(lon[1], -74.309027, 1e-5);
+    CU_ASSERT_DOUBLE_EQUAL(alt[1], 107.2, 1e-4);
+    CU_ASSERT_EQUAL(nsats[1], 7);
+    CU_ASSERT(isnan(lat[2]));
+
+    // full columns parse nothing
+    rc = gpsdata_parser_parse_columns(fsm, buf + consumed, buflen - consumed,
+            &cols, NULL);
+    CU_ASSERT_EQUAL(rc, 0);
+    // drain and resume
+    cols.count = 0;
+    size_t consumed2 = 0;
+    rc = gpsdata_parser_parse_columns(fsm, buf + consumed, buflen - consumed,
+            &cols, &consumed2);
+    CU_ASSERT_EQUAL(rc, 1);
+    CU_ASSERT_EQUAL(consumed + consumed2, buflen);
+    CU_ASSERT_EQUAL(msgid[0], GPSDATA_MSGID_PGTOP);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_columns_resume()
+{
+    // no spaces between the messages and a bad checksum on the GPGGA
+    const char *buf =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5E"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n";
+    size_t buflen = strlen(buf);
+    double lat[1];
+    uint8_t msgid[1], nsats[1];
+    uint8_t seen[4];
+    size_t nseen = 0;
+    size_t total = 0;
+    gpsdata_columns_t cols;
+    memset(&cols, 0, sizeof(cols));
+    cols.capacity = 1;
+    cols.latitude = lat;
+    cols.msgid = msgid;
+    cols.num_satellites = nsats;
+
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    while (total < buflen && nseen < 4) {
+        size_t consumed = 0;
+        cols.count = 0;
+        int rc = gpsdata_parser_parse_columns(fsm, buf + total, buflen - total,
+                    &cols, &consumed);
+        CU_ASSERT(rc >= 0);
+        if (rc < 0)
+            break;
+        if (rc == 1) {
+            seen[nseen++] = msgid[0];
+            if (msgid[0] == GPSDATA_MSGID_GPGGA) {
+                CU_ASSERT_DOUBLE_EQUAL(lat[0], 40.809988, 1e-5);
+                CU_ASSERT_EQUAL(nsats[0], 7);
+            }
+        }
+        CU_ASSERT(consumed > 0);
+        if (consumed == 0)
+            break;
+        total += consumed;
+    }
+    CU_ASSERT_EQUAL(total, buflen);
+    CU_ASSERT_EQUAL(nseen, 3);
+    if (nseen == 3) {
+        CU_ASSERT_EQUAL(seen[0], GPSDATA_MSGID_GPRMC);
+        CU_ASSERT_EQUAL(seen[1], GPSDATA_MSGID_GPGGA);
+        CU_ASSERT_EQUAL(seen[2], GPSDATA_MSGID_GPVTG);
+    }
+    gpsdata_parser_stats_t st;
+    CU_ASSERT_EQUAL(gpsdata_parser_get_stats(fsm, &st), 0);
+    CU_ASSERT_EQUAL(st.checksum_errors, 1);
+    gpsdata_parser_free(fsm);
+}
+
+static void test_parse_cb_counter(const gpsdata_data_t *item, void *userdata)
+{
+    CU_ASSERT_PTR_NOT_NULL(item);
+    CU_ASSERT_PTR_NOT_NULL(userdata);
+    if (item && userdata) {
+        size_t *counts = (size_t *)userdata;
+        CU_ASSERT(item->msgid <= GPSDATA_MSGID_PMTK);
+        counts[item->msgid]++;
+        gpsdata_dump(item, stdout);
+    }
+}
+
+void test_parse_cb()
+{
+    const char *buf =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n"
+        "$PGTOP,11,3*6F\r\n";
+    size_t counts[GPSDATA_MSGID_PMTK + 1];
+    size_t buflen = strlen(buf);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+
+    memset(counts, 0, sizeof(counts));
+    int rc = gpsdata_parser_parse_cb(fsm, buf, buflen, test_parse_cb_counter, counts);
+    CU_ASSERT_EQUAL(rc, 4);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_GPRMC], 1);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_GPGGA], 1);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_GPVTG], 1);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_PGTOP], 1);
+
+    // one byte at a time delivers each message once its checksum is done
+    memset(counts, 0, sizeof(counts));
+    int total = 0;
+    for (size_t idx = 0; idx < buflen; ++idx) {
+        rc = gpsdata_parser_parse_cb(fsm, &buf[idx], 1, test_parse_cb_counter, counts);
+        CU_ASSERT(rc >= 0);
+        if (rc > 0)
+            total += rc;
+    }
+    CU_ASSERT_EQUAL(total, 4);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_GPRMC], 1);
+    // nothing was drawn from the item pool
+    gpsdata_pool_stats_t stats = { 0 };
+    CU_ASSERT_EQUAL(gpsdata_parser_get_pool_stats(fsm, &stats), 0);
+    CU_ASSERT_EQUAL(stats.hits, 0);
+    CU_ASSERT_EQUAL(stats.misses, 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_cb(fsm, buf, buflen, NULL, NULL), -1);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_fixed()
+{
+    const char *buf =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n";
+    gpsdata_list_t list;
+    size_t onum = 0;
+    gpsdata_list_init(&list);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, strlen(buf), &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 3);
+    if (onum == 3) {
+        const gpsdata_data_t *rmc = list.head;
+        const gpsdata_data_t *gga = rmc->next;
+        const gpsdata_data_t *vtg = gga->next;
+        // 23 + 07.1256/60 degrees
+        CU_ASSERT_EQUAL(rmc->latitude_e7, 231187600);
+        CU_ASSERT_EQUAL(rmc->longitude_e7, 1202740633);
+        CU_ASSERT_EQUAL(rmc->speed_mmps, 15);
+        CU_ASSERT_EQUAL(rmc->altitude_mm, GPSDATA_FIXED_UNSET);
+        CU_ASSERT_EQUAL(gga->latitude_e7, 408099883);
+        CU_ASSERT_EQUAL(gga->longitude_e7, -743090267);
+        CU_ASSERT_EQUAL(gga->altitude_mm, 107200);
+        CU_ASSERT_DOUBLE_EQUAL(gpsdata_fixed_to_double(gga->altitude_mm, 1000), 107.2, 1e-9);
+        // the 1e-4 minutes round trip exactly
+        int32_t e7 = gga->latitude_e7 % 10000000;
+        CU_ASSERT_EQUAL((e7 * INT64_C(3) + 25) / 50, 485993);
+        CU_ASSERT_EQUAL(vtg->speed_mmps, 566);
+        CU_ASSERT_EQUAL(vtg->latitude_e7, GPSDATA_FIXED_UNSET);
+        CU_ASSERT(isnan(gpsdata_fixed_to_double(vtg->latitude_e7, 10000000)));
+    }
+    gpsdata_list_clear(&list);
+
+    // an integer part too large to hold leaves the field unset
+    const char *big =
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,1234567890123456.5,M,-34.2,M,,*6A\r\n";
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, big, strlen(big), &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 1);
+    if (onum == 1) {
+        CU_ASSERT_EQUAL(list.head->altitude_mm, GPSDATA_FIXED_UNSET);
+        CU_ASSERT(isnan(list.head->altitude_meters));
+        CU_ASSERT_EQUAL(list.head->latitude_e7, 408099883);
+    }
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_filter()
+{
+    const char *buf =
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$PGTOP,11,3*6F\r\n";
+    size_t buflen = strlen(buf);
+    uint64_t drops[GPSDATA_MSGID_COUNT];
+    gpsdata_list_t list;
+    size_t onum = 0;
+    gpsdata_list_init(&list);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_filter(fsm, GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGGA)), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 2);
+    if (onum == 2) {
+        CU_ASSERT_EQUAL(list.head->msgid, GPSDATA_MSGID_GPGGA);
+        CU_ASSERT(!list.head->is_valid_timestamp);
+        // the filtered GPRMC still provided the date
+        CU_ASSERT_EQUAL(list.tail->msgid, GPSDATA_MSGID_GPGGA);
+        CU_ASSERT(list.tail->is_valid_timestamp);
+    }
+    CU_ASSERT_EQUAL(gpsdata_parser_get_filter_drops(fsm, drops), 0);
+    CU_ASSERT_EQUAL(drops[GPSDATA_MSGID_GPRMC], 1);
+    CU_ASSERT_EQUAL(drops[GPSDATA_MSGID_GPVTG], 1);
+    CU_ASSERT_EQUAL(drops[GPSDATA_MSGID_PGTOP], 1);
+    CU_ASSERT_EQUAL(drops[GPSDATA_MSGID_GPGGA], 0);
+    gpsdata_list_clear(&list);
+
+    // one byte at a time nothing is skipped ahead but the result is the same
+    gpsdata_parser_reset(fsm);
+    for (size_t idx = 0; idx < buflen; ++idx) {
+        CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, &buf[idx], 1, &list, NULL), 0);
+    }
+    CU_ASSERT_EQUAL(list.count, 2);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_filter_drops(fsm, drops), 0);
+    CU_ASSERT_EQUAL(drops[GPSDATA_MSGID_GPVTG], 2);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+}
+
+static void test_parse_ack_counter(uint16_t cmd, uint8_t flag, void *userdata)
+{
+    size_t *acks = (size_t *)userdata;
+    CU_ASSERT(cmd == 220 || cmd == 314);
+    CU_ASSERT_EQUAL(flag, 3);
+    (*acks)++;
+}
+
+void test_parse_ack_filter()
+{
+    const char *buf =
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$PMTK001,220,3*30\r\n$PMTK001,314,3*36\r\n";
+    size_t buflen = strlen(buf);
+    size_t acks = 0;
+    gpsdata_list_t list;
+    size_t onum = 0;
+    gpsdata_list_init(&list);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    // the filter leaves out PMTK but the acknowledgements still arrive
+    CU_ASSERT_EQUAL(gpsdata_parser_set_filter(fsm, GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGGA) |
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPRMC)), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_ack_cb(fsm, test_parse_ack_counter, &acks), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 1);
+    CU_ASSERT_EQUAL(acks, 2);
+    gpsdata_list_clear(&list);
+    // and so do those split across buffers
+    for (size_t idx = 0; idx < buflen; ++idx) {
+        CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, &buf[idx], 1, &list, &onum), 0);
+    }
+    CU_ASSERT_EQUAL(list.count, 1);
+    CU_ASSERT_EQUAL(acks, 4);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_bad_checksum()
+{
+    const char *buf =
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2D\r\n"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n";
+    size_t counts[GPSDATA_MSGID_PMTK + 1];
+    size_t buflen = strlen(buf);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+
+    // the whole buffer is available so the bad message is skipped ahead
+    memset(counts, 0, sizeof(counts));
+    int rc = gpsdata_parser_parse_cb(fsm, buf, buflen, test_parse_cb_counter, counts);
+    CU_ASSERT_EQUAL(rc, 2);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_GPGGA], 1);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_GPRMC], 0);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_GPVTG], 1);
+
+    // one byte at a time the bad message is parsed and rejected at the end
+    memset(counts, 0, sizeof(counts));
+    int total = 0;
+    for (size_t idx = 0; idx < buflen; ++idx) {
+        rc = gpsdata_parser_parse_cb(fsm, &buf[idx], 1, test_parse_cb_counter, counts);
+        CU_ASSERT(rc >= 0);
+        if (rc > 0)
+            total += rc;
+    }
+    CU_ASSERT_EQUAL(total, 2);
+    CU_ASSERT_EQUAL(counts[GPSDATA_MSGID_GPRMC], 0);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_resync()
+{
+    const char *buf =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+        "$GPGGA,1859#16.000,4048.5993,N\r\n"
+        "$GPVTG,7.37,T,,M,1.10,$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n";
+    size_t buflen = strlen(buf);
+    gpsdata_list_t list;
+    size_t onum = 0;
+    size_t errors = 0;
+    size_t dropped = 0;
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+
+    gpsdata_list_init(&list);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum), -1);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_reset(fsm);
+
+    CU_ASSERT_EQUAL(gpsdata_parser_set_resync(fsm, true), 0);
+    int rc = gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum);
+    CU_ASSERT_EQUAL(rc, 2);
+    CU_ASSERT_EQUAL(onum, 3);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_resync_stats(fsm, &errors, &dropped), 0);
+    CU_ASSERT_EQUAL(errors, 2);
+    CU_ASSERT(dropped > 0);
+    if (list.count == 3) {
+        CU_ASSERT_EQUAL(list.head->msgid, GPSDATA_MSGID_GPRMC);
+        CU_ASSERT_EQUAL(list.head->next->msgid, GPSDATA_MSGID_GPGGA);
+        // the GPRMC date survived the errors
+        CU_ASSERT(list.head->next->is_valid_timestamp);
+        CU_ASSERT_EQUAL(list.tail->msgid, GPSDATA_MSGID_GPVTG);
+    }
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_generator()
+{
+    const size_t buflen = 64 * 1024;
+    char *buf = calloc(1, buflen);
+    char *buf2 = calloc(1, buflen);
+    CU_ASSERT_PTR_NOT_NULL(buf);
+    CU_ASSERT_PTR_NOT_NULL(buf2);
+    if (!buf || !buf2) {
+        GPSUTILS_FREE(buf);
+        GPSUTILS_FREE(buf2);
+        return;
+    }
+    gpsdata_generator_config_t config;
+    gpsdata_generator_config_default(&config);
+    gpsdata_generator_t *gen = gpsdata_generator_create(&config);
+    gpsdata_generator_t *gen2 = gpsdata_generator_create(&config);
+    CU_ASSERT_PTR_NOT_NULL(gen);
+    CU_ASSERT_PTR_NOT_NULL(gen2);
+    CU_ASSERT_EQUAL(gpsdata_generator_fill(gen, buf, buflen), (ssize_t)buflen);
+    // the same seed gives the same stream irrespective of the buffer sizes
+    for (size_t off = 0; off < buflen; off += 1000) {
+        size_t n = (buflen - off < 1000) ? buflen - off : 1000;
+        CU_ASSERT_EQUAL(gpsdata_generator_fill(gen2, buf2 + off, n), (ssize_t)n);
+    }
+    CU_ASSERT_EQUAL(memcmp(buf, buf2, buflen), 0);
+    gpsdata_generator_stats_t stats;
+    CU_ASSERT_EQUAL(gpsdata_generator_get_stats(gen, &stats), 0);
+    CU_ASSERT_EQUAL(stats.bytes, buflen);
+    CU_ASSERT_EQUAL(stats.bad_checksums + stats.bitflips + stats.truncations, 0);
+
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    gpsdata_list_t list;
+    gpsdata_list_init(&list);
+    size_t onum = 0;
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum), 0);
+    CU_ASSERT(onum > 0);
+    size_t gga = 0;
+    const gpsdata_data_t *item = NULL;
+    LL_FOREACH(list.head, item) {
+        if (item->msgid == GPSDATA_MSGID_GPGGA) {
+            gga++;
+            CU_ASSERT_EQUAL(item->posfix, GPSDATA_POSFIX_GPSFIX);
+        }
+    }
+    // the stream may end inside the GPGGA message of the last fix
+    CU_ASSERT(gga <= stats.fixes && gga + 1 >= stats.fixes);
+    gpsdata_skyview_t sky;
+    CU_ASSERT_EQUAL(gpsdata_parser_get_skyview(fsm, &sky), 0);
+    CU_ASSERT(sky.seq > 0);
+    CU_ASSERT_EQUAL(sky.num_in_view, 12);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+    gpsdata_generator_free(gen);
+    gpsdata_generator_free(gen2);
+
+    // a corrupted stream is recovered from with resync
+    config.bitflip_rate = 0.02;
+    config.truncate_rate = 0.02;
+    config.bad_checksum_rate = 0.02;
+    gen = gpsdata_generator_create(&config);
+    CU_ASSERT_PTR_NOT_NULL(gen);
+    CU_ASSERT_EQUAL(gpsdata_generator_fill(gen, buf, buflen), (ssize_t)buflen);
+    CU_ASSERT_EQUAL(gpsdata_generator_get_stats(gen, &stats), 0);
+    CU_ASSERT(stats.bad_checksums > 0 && stats.bitflips > 0 && stats.truncations > 0);
+    fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_resync(fsm, true), 0);
+    int rc = gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum);
+    // the errors are counted instead of failing the parse
+    CU_ASSERT(rc >= 0);
+    CU_ASSERT(onum > 0);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+    gpsdata_generator_free(gen);
+    GPSUTILS_FREE(buf);
+    GPSUTILS_FREE(buf2);
+}
+
+void test_parse_stats()
+{
+    const char *buf =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5E\r\n"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n"
+        "$GPGSV,2,1,07,21,67,278,18,15,66,048,38,20,46,302,26,24,38,154,13*72\r\n"
+        "$GPGSV,2,2,07,13,33,048,22,10,19,289,17,41,,,*79\r\n"
+        "$PGTOP,11,3*6F\r\n";
+    const char *gpvtg = "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n";
+    size_t buflen = strlen(buf);
+    gpsdata_list_t list;
+    gpsdata_list_init(&list);
+    size_t onum = 0;
+    gpsdata_parser_stats_t stats;
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_stats(fsm, NULL), -1);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_latency_histogram(fsm, true), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 4);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_stats(fsm, &stats), 0);
+    CU_ASSERT_EQUAL(stats.parse_calls, 1);
+    CU_ASSERT_EQUAL(stats.bytes, buflen);
+    CU_ASSERT_EQUAL(stats.sentences[GPSDATA_MSGID_GPRMC], 1);
+    CU_ASSERT_EQUAL(stats.sentences[GPSDATA_MSGID_GPGGA], 1);
+    CU_ASSERT_EQUAL(stats.sentences[GPSDATA_MSGID_GPVTG], 1);
+    CU_ASSERT_EQUAL(stats.sentences[GPSDATA_MSGID_GPGSV], 2);
+    CU_ASSERT_EQUAL(stats.sentences[GPSDATA_MSGID_PGTOP], 1);
+    CU_ASSERT_EQUAL(stats.delivered[GPSDATA_MSGID_GPGGA], 1);
+    CU_ASSERT_EQUAL(stats.delivered[GPSDATA_MSGID_GPGSV], 0);
+    CU_ASSERT_EQUAL(stats.delivered[GPSDATA_MSGID_PGTOP], 1);
+    CU_ASSERT_EQUAL(stats.checksum_errors, 1);
+    // the GPGSV messages go to the sky view instead
+    CU_ASSERT_EQUAL(stats.ignored, 2);
+    CU_ASSERT_EQUAL(stats.resync_errors, 0);
+    CU_ASSERT_EQUAL(stats.alloc_failures, 0);
+    uint64_t calls = 0;
+    for (size_t i = 0; i < GPSDATA_PARSER_LATENCY_BUCKETS; ++i)
+        calls += stats.latency_ns[i];
+    CU_ASSERT_EQUAL(calls, 1);
+    gpsdata_list_clear(&list);
+
+    CU_ASSERT_EQUAL(gpsdata_parser_set_latency_histogram(fsm, false), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_filter(fsm,
+                GPSDATA_MSGID_MASK_ALL & ~GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPVTG)), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, gpvtg, strlen(gpvtg), &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_stats(fsm, &stats), 0);
+    CU_ASSERT_EQUAL(stats.parse_calls, 2);
+    CU_ASSERT_EQUAL(stats.sentences[GPSDATA_MSGID_GPVTG], 2);
+    CU_ASSERT_EQUAL(stats.delivered[GPSDATA_MSGID_GPVTG], 1);
+    CU_ASSERT_EQUAL(stats.filter_drops[GPSDATA_MSGID_GPVTG], 1);
+    calls = 0;
+    for (size_t i = 0; i < GPSDATA_PARSER_LATENCY_BUCKETS; ++i)
+        calls += stats.latency_ns[i];
+    CU_ASSERT_EQUAL(calls, 1);
+
+    CU_ASSERT_EQUAL(gpsdata_parser_reset_stats(fsm), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_stats(fsm, &stats), 0);
+    CU_ASSERT_EQUAL(stats.parse_calls, 0);
+    CU_ASSERT_EQUAL(stats.bytes, 0);
+    CU_ASSERT_EQUAL(stats.sentences[GPSDATA_MSGID_GPVTG], 0);
+    CU_ASSERT_EQUAL(stats.checksum_errors, 0);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_rx_time()
+{
+    const char *buf =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n";
+    size_t buflen = strlen(buf);
+    size_t gga_off = strchr(buf + 1, '$') - buf;
+    const int64_t rx = INT64_C(1145000000000000);
+    const uint64_t byte_nsec = 10000000000ULL / 9600;
+    gpsdata_list_t list;
+    gpsdata_list_init(&list);
+    size_t onum = 0;
+    gpsdata_rx_offset_stats_t ro;
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_baudrate(fsm, 9600), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_rx_time(fsm, rx), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 2);
+    if (list.count == 2) {
+        const gpsdata_data_t *rmc = list.head;
+        const gpsdata_data_t *gga = list.tail;
+        // the '$' of each message arrived this long before the last byte
+        CU_ASSERT_EQUAL(rmc->rx_usec,
+                rx - (int64_t)((buflen - 1) * byte_nsec / 1000));
+        CU_ASSERT_EQUAL(gga->rx_usec,
+                rx - (int64_t)((buflen - 1 - gga_off) * byte_nsec / 1000));
+        CU_ASSERT(rmc->is_valid_timestamp);
+        CU_ASSERT(gga->is_valid_timestamp);
+        int64_t off1 = rmc->rx_usec - ((int64_t)rmc->timestamp.tv_sec * 1000000 +
+                            rmc->timestamp.tv_usec);
+        int64_t off2 = gga->rx_usec - ((int64_t)gga->timestamp.tv_sec * 1000000 +
+                            gga->timestamp.tv_usec);
+        CU_ASSERT_EQUAL(gpsdata_parser_get_rx_offset_stats(fsm, &ro), 0);
+        CU_ASSERT_EQUAL(ro.count, 2);
+        CU_ASSERT_EQUAL(ro.last_usec, off2);
+        CU_ASSERT_EQUAL(ro.min_usec, (off1 < off2) ? off1 : off2);
+        CU_ASSERT_EQUAL(ro.max_usec, (off1 < off2) ? off2 : off1);
+        CU_ASSERT_DOUBLE_EQUAL(ro.mean_usec, ((double)off1 + (double)off2) / 2, 1.0);
+        CU_ASSERT_DOUBLE_EQUAL(ro.jitter_usec, fabs((double)(off2 - off1)) / 16, 1.0);
+        CU_ASSERT(ro.stddev_usec > 0);
+    }
+    gpsdata_list_clear(&list);
+    // the time applies to a single parse call
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, buflen, &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 2);
+    if (list.count == 2) {
+        CU_ASSERT_EQUAL(list.head->rx_usec, 0);
+        CU_ASSERT_EQUAL(list.tail->rx_usec, 0);
+    }
+    CU_ASSERT_EQUAL(gpsdata_parser_get_rx_offset_stats(fsm, &ro), 0);
+    CU_ASSERT_EQUAL(ro.count, 2);
+    CU_ASSERT_EQUAL(gpsdata_parser_reset_stats(fsm), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_get_rx_offset_stats(fsm, &ro), 0);
+    CU_ASSERT_EQUAL(ro.count, 0);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+}
+
+void test_device_fix_interval()
+{
+    // GPRMC and GPGGA only fit 5 fixes a second in 80% of 9600 bps
+    CU_ASSERT_EQUAL(gpsdevice_min_fix_interval(9600, false, false, false), 200);
+    CU_ASSERT_EQUAL(gpsdevice_min_fix_interval(9600, true, true, true), 400);
+    CU_ASSERT_EQUAL(gpsdevice_min_fix_interval(4800, true, true, true), 800);
+    CU_ASSERT_EQUAL(gpsdevice_min_fix_interval(115200, true, true, true), 100);
+    CU_ASSERT_EQUAL(gpsdevice_min_fix_interval(1200, true, true, true), 3100);
+    CU_ASSERT_EQUAL(gpsdevice_min_fix_interval(12345, false, false, false), 0);
+    CU_ASSERT_EQUAL(gpsdevice_set_fix_interval_safe(-1, 9600, 100, false, false, false), -1);
+    CU_ASSERT_EQUAL(gpsdevice_negotiate_baudrate(-1, 9600, 115200, 0), -1);
+}
+
+#if defined(LIBGPS_MTK3339_HAVE_PTY_H) && defined(LIBGPS_MTK3339_HAVE_OPENPTY)
+/* the GPS end of a pty. Once it has seen the trigger command it keeps sending
+ * a sentence preceded by noise and split in two writes, the way a chip sends
+ * one per fix, until it is told to stop. A NULL trigger stays silent. */
+typedef struct {
+    int fd;
+    const char *trigger;
+    atomic_bool done;
+} test_device_peer_t;
+
+static void *test_device_peer(void *arg)
+{
+    test_device_peer_t *peer = (test_device_peer_t *)arg;
+    const char *rmc =
+        "~~\xff$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n";
+    char seen[512];
+    size_t seen_len = 0;
+    bool triggered = false;
+    struct timespec ts = { 0, 10000000L };
+    memset(seen, 0, sizeof(seen));
+    while (!atomic_load(&(peer->done))) {
+        char buf[128];
+        ssize_t nb = read(peer->fd, buf, sizeof(buf));
+        for (ssize_t i = 0; i < nb && seen_len < sizeof(seen) - 1; ++i)
+            seen[seen_len++] = buf[i] ? buf[i] : ' ';
+        if (peer->trigger && strstr(seen, peer->trigger))
+            triggered = true;
+        if (triggered) {
+            struct timespec gap = { 0, 2000000L };
+            size_t half = strlen(rmc) / 2;
+            if (write(peer->fd, rmc, half) < 0)
+                break;
+            nanosleep(&gap, NULL);
+            if (write(peer->fd, rmc + half, strlen(rmc) - half) < 0)
+                break;
+        }
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+static int test_device_negotiate_with(const char *trigger, uint32_t baud_rate)
+{
+    int master = -1, slave = -1;
+    CU_ASSERT_EQUAL(openpty(&master, &slave, NULL, NULL, NULL), 0);
+    if (master < 0 || slave < 0)
+        return -2;
+    CU_ASSERT_EQUAL(fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK), 0);
+    test_device_peer_t peer = { master, trigger, false };
+    pthread_t thread;
+    CU_ASSERT_EQUAL(pthread_create(&thread, NULL, test_device_peer, &peer), 0);
+    int rc = gpsdevice_negotiate_baudrate(slave, 9600, baud_rate, 300);
+    atomic_store(&(peer.done), true);
+    pthread_join(thread, NULL);
+    close(slave);
+    close(master);
+    return rc;
+}
+#endif
+
+void test_device_negotiate()
+{
+#if defined(LIBGPS_MTK3339_HAVE_PTY_H) && defined(LIBGPS_MTK3339_HAVE_OPENPTY)
+    // the chip answers at the new rate
+    CU_ASSERT_EQUAL(test_device_negotiate_with("$PMTK251,115200*", 115200), 115200);
+    // the chip only answers once it is told to go back to the old rate
+    CU_ASSERT_EQUAL(test_device_negotiate_with("$PMTK251,9600*", 115200), 9600);
+    // the chip never answers
+    CU_ASSERT_EQUAL(test_device_negotiate_with(NULL, 115200), -1);
+    // the same rate is only sent
+    CU_ASSERT_EQUAL(test_device_negotiate_with(NULL, 9600), 9600);
+    CU_ASSERT_EQUAL(test_device_negotiate_with(NULL, 12345), -1);
+#endif
+}
+
+typedef struct {
+    size_t count;
+    uint16_t cmd;
+    gpsdevice_cmd_status_t status;
+} test_device_cmdq_result_t;
+
+static void test_device_cmdq_cb(uint16_t cmd, gpsdevice_cmd_status_t status,
+                void *userdata)
+{
+    test_device_cmdq_result_t *res = (test_device_cmdq_result_t *)userdata;
+    res->count++;
+    res->cmd = cmd;
+    res->status = status;
+}
+
+static size_t test_device_cmdq_read(int fd, char *buf, size_t len)
+{
+    ssize_t nb = read(fd, buf, len - 1);
+    buf[(nb > 0) ? nb : 0] = '\0';
+    return (nb > 0) ? (size_t)nb : 0;
+}
+
+void test_device_cmdq()
+{
+    int pfd[2] = { -1, -1 };
+    char buf[256];
+    const char *ack = "$PMTK001,220,3*30\r\n";
+    test_device_cmdq_result_t res = { 0, 0, GPSDEVICE_CMD_INVALID };
+    struct timespec ts = { 0, 5000000L };
+    CU_ASSERT_EQUAL(pipe(pfd), 0);
+    gpsdevice_cmdq_t *q = gpsdevice_cmdq_create(pfd[1], 1, 1, 4);
+    CU_ASSERT_PTR_NOT_NULL(q);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "GPGGA,1", NULL, NULL), -1);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK", NULL, NULL), -1);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK2200", NULL, NULL), -1);
+    // different IDs are pipelined and the second PMTK220 waits for the first
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK220,200", test_device_cmdq_cb, &res), 0);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK220,1000", test_device_cmdq_cb, &res), 0);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK314,0,1,0,1,1,5,0,0,0,0,0,0,0,0,0,0,0,0,0",
+                test_device_cmdq_cb, &res), 0);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_pending(q), 3);
+    CU_ASSERT(test_device_cmdq_read(pfd[0], buf, sizeof(buf)) > 0);
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "$PMTK220,200*"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "$PMTK314,0,1,0,1,1,5,"));
+    CU_ASSERT_PTR_NULL(strstr(buf, "PMTK220,1000"));
+
+    // the ack comes through the parser and is still not an item
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_ack_cb(fsm, gpsdevice_cmdq_parser_ack, q), 0);
+    gpsdata_data_t *outp = NULL;
+    size_t onum = 0;
+    CU_ASSERT(gpsdata_parser_parse(fsm, ack, strlen(ack), &outp, &onum) >= 0);
+    CU_ASSERT_EQUAL(onum, 0);
+    CU_ASSERT_PTR_NULL(outp);
+    CU_ASSERT_EQUAL(res.count, 1);
+    CU_ASSERT_EQUAL(res.cmd, 220);
+    CU_ASSERT_EQUAL(res.status, GPSDEVICE_CMD_SUCCESS);
+    CU_ASSERT(test_device_cmdq_read(pfd[0], buf, sizeof(buf)) > 0);
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "$PMTK220,1000*"));
+    gpsdata_parser_free(fsm);
+
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_ack(q, 103, 3), -1);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_ack(q, 314, 1), 0);
+    CU_ASSERT_EQUAL(res.count, 2);
+    CU_ASSERT_EQUAL(res.cmd, 314);
+    CU_ASSERT_EQUAL(res.status, GPSDEVICE_CMD_UNSUPPORTED);
+
+    // one retry and then a timeout
+    nanosleep(&ts, NULL);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_poll(q), 1);
+    CU_ASSERT(test_device_cmdq_read(pfd[0], buf, sizeof(buf)) > 0);
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "$PMTK220,1000*"));
+    nanosleep(&ts, NULL);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_poll(q), 0);
+    CU_ASSERT_EQUAL(res.count, 3);
+    CU_ASSERT_EQUAL(res.cmd, 220);
+    CU_ASSERT_EQUAL(res.status, GPSDEVICE_CMD_TIMEDOUT);
+
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK225,0", test_device_cmdq_cb, &res), 0);
+    gpsdevice_cmdq_free(q);
+    CU_ASSERT_EQUAL(res.count, 4);
+    CU_ASSERT_EQUAL(res.cmd, 225);
+    CU_ASSERT_EQUAL(res.status, GPSDEVICE_CMD_CANCELLED);
+    close(pfd[0]);
+    close(pfd[1]);
+}
+
+typedef struct {
+    gpsdevice_cmdq_t *q;
+    int ack_rc;
+    test_device_cmdq_result_t res;
+} test_device_cmdq_chain_t;
+
+// completes PMTK314 from the callback of another command
+static void test_device_cmdq_chain_cb(uint16_t cmd, gpsdevice_cmd_status_t status,
+                void *userdata)
+{
+    test_device_cmdq_chain_t *chain = (test_device_cmdq_chain_t *)userdata;
+    test_device_cmdq_cb(cmd, status, &(chain->res));
+    chain->ack_rc = gpsdevice_cmdq_ack(chain->q, 314, 3);
+}
+
+void test_device_cmdq_reentrant()
+{
+    int pfd[2] = { -1, -1 };
+    test_device_cmdq_result_t res = { 0, 0, GPSDEVICE_CMD_INVALID };
+    test_device_cmdq_chain_t chain = { NULL, -1, { 0, 0, GPSDEVICE_CMD_INVALID } };
+    struct timespec ts = { 0, 30000000L };
+    CU_ASSERT_EQUAL(pipe(pfd), 0);
+    gpsdevice_cmdq_t *q = gpsdevice_cmdq_create(pfd[1], 20, 0, 4);
+    CU_ASSERT_PTR_NOT_NULL(q);
+    chain.q = q;
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK220,200", test_device_cmdq_chain_cb,
+                &chain), 0);
+    nanosleep(&ts, NULL);
+    // the timed out PMTK220 completes the PMTK314 that comes after it
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK314,0,1,0,1,1,5,0,0,0,0,0,0,0,0,0,0,0,0,0",
+                test_device_cmdq_cb, &res), 0);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_pending(q), 2);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_poll(q), 0);
+    CU_ASSERT_EQUAL(chain.res.count, 1);
+    CU_ASSERT_EQUAL(chain.res.cmd, 220);
+    CU_ASSERT_EQUAL(chain.res.status, GPSDEVICE_CMD_TIMEDOUT);
+    CU_ASSERT_EQUAL(chain.ack_rc, 0);
+    CU_ASSERT_EQUAL(res.count, 1);
+    CU_ASSERT_EQUAL(res.cmd, 314);
+    CU_ASSERT_EQUAL(res.status, GPSDEVICE_CMD_SUCCESS);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_pending(q), 0);
+    gpsdevice_cmdq_free(q);
+    close(pfd[0]);
+    close(pfd[1]);
+}
+
+static void test_device_writer_hook(int fd, bool want_writable, void *userdata)
+{
+    int *want = (int *)userdata;
+    (void)fd;
+    *want = want_writable ? 1 : 0;
+}
+
+void test_device_writer()
+{
+    int pfd[2] = { -1, -1 };
+    char buf[256];
+    char junk[4096];
+    int want = -1;
+    const char *msg = "$PMTK220,200*2C\r\n";
+    CU_ASSERT_EQUAL(pipe(pfd), 0);
+    CU_ASSERT_EQUAL(fcntl(pfd[0], F_SETFL, fcntl(pfd[0], F_GETFL) | O_NONBLOCK), 0);
+    CU_ASSERT_EQUAL(fcntl(pfd[1], F_SETFL, fcntl(pfd[1], F_GETFL) | O_NONBLOCK), 0);
+    CU_ASSERT_PTR_NULL(gpsdevice_writer_create(-1, 0));
+    gpsdevice_writer_t *w = gpsdevice_writer_create(pfd[1], 40);
+    CU_ASSERT_PTR_NOT_NULL(w);
+    CU_ASSERT_EQUAL(gpsdevice_writer_set_hook(w, test_device_writer_hook, &want), 0);
+    CU_ASSERT_EQUAL(gpsdevice_writer_flush(w), 0);
+    CU_ASSERT_EQUAL(want, -1);
+
+    // two messages go out in one write and a third does not fit
+    CU_ASSERT_EQUAL(gpsdevice_writer_queue(w, msg), 0);
+    CU_ASSERT_EQUAL(want, 1);
+    CU_ASSERT_EQUAL(gpsdevice_writer_queue(w, msg), 0);
+    CU_ASSERT_EQUAL(gpsdevice_writer_queue(w, msg), -1);
+    CU_ASSERT_EQUAL(gpsdevice_writer_pending(w), 2 * strlen(msg));
+    CU_ASSERT_EQUAL(gpsdevice_writer_flush(w), 0);
+    CU_ASSERT_EQUAL(want, 0);
+    ssize_t nb = read(pfd[0], buf, sizeof(buf) - 1);
+    CU_ASSERT_EQUAL(nb, (ssize_t)(2 * strlen(msg)));
+    buf[(nb > 0) ? nb : 0] = '\0';
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, msg));
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf + strlen(msg), msg));
+
+    // a full fd keeps the message queued until it is writable again
+    memset(junk, 'x', sizeof(junk));
+    while (write(pfd[1], junk, sizeof(junk)) > 0);
+    while (write(pfd[1], junk, 1) > 0);
+    CU_ASSERT_EQUAL(gpsdevice_writer_queue(w, msg), 0);
+    CU_ASSERT_EQUAL(want, 1);
+    CU_ASSERT_EQUAL(gpsdevice_writer_flush(w), (ssize_t)strlen(msg));
+    CU_ASSERT_EQUAL(want, 1);
+    size_t drained = 0;
+    while ((nb = read(pfd[0], junk, sizeof(junk))) == (ssize_t)sizeof(junk))
+        drained += (size_t)nb;
+    CU_ASSERT(drained > 0);
+    CU_ASSERT_EQUAL(gpsdevice_writer_flush(w), 0);
+    CU_ASSERT_EQUAL(want, 0);
+    nb = read(pfd[0], buf, sizeof(buf) - 1);
+    CU_ASSERT_EQUAL(nb, (ssize_t)strlen(msg));
+
+    // the command queue writes through the writer
+    gpsdevice_cmdq_t *q = gpsdevice_cmdq_create(pfd[1], 0, 0, 0);
+    CU_ASSERT_PTR_NOT_NULL(q);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_set_writer(q, w), 0);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_submit(q, "PMTK220,200", NULL, NULL), 0);
+    CU_ASSERT_EQUAL(gpsdevice_writer_pending(w), strlen(msg));
+    CU_ASSERT_EQUAL(gpsdevice_writer_flush(w), 0);
+    nb = read(pfd[0], buf, sizeof(buf) - 1);
+    CU_ASSERT_EQUAL(nb, (ssize_t)strlen(msg));
+    buf[(nb > 0) ? nb : 0] = '\0';
+    CU_ASSERT_STRING_EQUAL(buf, msg);
+    CU_ASSERT_EQUAL(gpsdevice_cmdq_ack(q, 220, 3), 0);
+    gpsdevice_cmdq_free(q);
+
+    // a hard error drops the queue and disarms the hook, the next message
+    // arms it again
+    void (*old_sig)(int) = signal(SIGPIPE, SIG_IGN);
+    close(pfd[0]);
+    pfd[0] = -1;
+    CU_ASSERT_EQUAL(gpsdevice_writer_queue(w, msg), 0);
+    CU_ASSERT_EQUAL(gpsdevice_writer_queue(w, msg), 0);
+    CU_ASSERT_EQUAL(want, 1);
+    CU_ASSERT_EQUAL(gpsdevice_writer_flush(w), -1);
+    CU_ASSERT_EQUAL(want, 0);
+    CU_ASSERT_EQUAL(gpsdevice_writer_pending(w), 0);
+    CU_ASSERT_EQUAL(gpsdevice_writer_queue(w, msg), 0);
+    CU_ASSERT_EQUAL(want, 1);
+    CU_ASSERT_EQUAL(gpsdevice_writer_pending(w), strlen(msg));
+    CU_ASSERT_EQUAL(gpsdevice_writer_flush(w), -1);
+    CU_ASSERT_EQUAL(want, 0);
+    signal(SIGPIPE, old_sig);
+    gpsdevice_writer_free(w);
+    close(pfd[1]);
+}
+
+static void test_parse_logsink_count(void *ctx, int level, const char *fmt,
+                const char *msg, size_t len)
+{
+    (void)fmt;
+    (void)len;
+    if (level == GPSUTILS_LOGLEVEL_WARN && strstr(msg, "RMC date"))
+        (*(size_t *)ctx)++;
+}
+
+void test_parse_logsink()
+{
+    const char *gga =
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n";
+    const char *rmc =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n";
+    size_t warnings = 0;
+    gpsutils_logsink_t sink = { test_parse_logsink_count, &warnings };
+    gpsdata_list_t list;
+    gpsdata_list_init(&list);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_logsink(fsm, &sink), 0);
+    // the missing date is reported once, not for every message
+    for (int i = 0; i < 5; ++i) {
+        CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, gga, strlen(gga), &list, NULL), 0);
+    }
+    CU_ASSERT_EQUAL(list.count, 5);
+    CU_ASSERT_EQUAL(warnings, 1);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, rmc, strlen(rmc), &list, NULL), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, gga, strlen(gga), &list, NULL), 0);
+    CU_ASSERT_EQUAL(warnings, 1);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+}
+
+void test_parse_fusion()
+{
+    const char *epoch1 =
+        "$GPGGA,064951.000,2307.1256,N,12016.4438,E,1,08,0.95,39.9,M,17.8,M,,*53\r\n"
+        "$GPGSA,A,3,29,21,26,15,18,09,06,10,,,,,2.32,0.95,2.11*00\r\n"
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\r\n"
+        "$GPVTG,165.48,T,,M,0.03,N,0.06,K,A*36\r\n";
+    const char *epoch2 =
+        "$GPGGA,064952.000,2307.1257,N,12016.4439,E,1,08,0.96,40.0,M,17.8,M,,*54\r\n";
+    const char *pgtop = "$PGTOP,11,3*6F\r\n";
+    gpsdata_list_t list;
+    size_t onum = 0;
+    gpsdata_list_init(&list);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_fusion(fsm, true, 0), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, epoch1, strlen(epoch1), &list, &onum), 0);
+    // the epoch is still open
+    CU_ASSERT_EQUAL(onum, 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, epoch2, strlen(epoch2), &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 1);
+    if (onum == 1) {
+        const gpsdata_data_t *item = list.head;
+        CU_ASSERT_EQUAL(item->msgid, GPSDATA_MSGID_GPGGA);
+        CU_ASSERT_EQUAL(item->fused_msgids,
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGGA) |
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGSA) |
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPRMC) |
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPVTG));
+        CU_ASSERT(item->is_valid_timestamp);
+        CU_ASSERT_EQUAL(item->latitude_e7, 231187600);
+        CU_ASSERT_EQUAL(item->altitude_mm, 39900);
+        CU_ASSERT_EQUAL(item->posfix, GPSDATA_POSFIX_GPSFIX);
+        CU_ASSERT_EQUAL(item->num_satellites, 8);
+        CU_ASSERT_EQUAL(item->mode, GPSDATA_MODE_AUTONOMOUS);
+        CU_ASSERT_EQUAL(item->speed_mmps, 15);
+        CU_ASSERT_DOUBLE_EQUAL(item->course_degrees, 165.48, 0.001);
+        CU_ASSERT_DOUBLE_EQUAL(item->speed_kmph, 0.06, 0.001);
+        CU_ASSERT_DOUBLE_EQUAL(item->dop.pdop, 2.32, 0.001);
+        CU_ASSERT_DOUBLE_EQUAL(item->dop.hdop, 0.95, 0.001);
+        CU_ASSERT_DOUBLE_EQUAL(item->dop.vdop, 2.11, 0.001);
+        CU_ASSERT_EQUAL(item->gsa.fix, GPSDATA_MODE_3DFIX);
+        CU_ASSERT_EQUAL(item->gsa.num_used, 8);
+    }
+    CU_ASSERT_EQUAL(gpsdata_parser_flush(fsm, &list), 1);
+    CU_ASSERT_EQUAL(list.count, 2);
+    if (list.count == 2) {
+        CU_ASSERT_EQUAL(list.tail->fused_msgids, GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGGA));
+        CU_ASSERT_EQUAL(list.tail->latitude_e7, 231187617);
+        CU_ASSERT(list.tail->is_valid_timestamp);
+        CU_ASSERT_EQUAL(list.tail->timestamp.tv_sec, list.head->timestamp.tv_sec + 1);
+    }
+    CU_ASSERT_EQUAL(gpsdata_parser_flush(fsm, &list), 0);
+    gpsdata_list_clear(&list);
+
+    // the timed out epoch is delivered before the next buffer is parsed
+    CU_ASSERT_EQUAL(gpsdata_parser_set_fusion(fsm, true, 1), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, epoch1, strlen(epoch1), &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 0);
+    struct timespec ts = { 0, 5000000L };
+    nanosleep(&ts, NULL);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, pgtop, strlen(pgtop), &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 2);
+    if (onum == 2) {
+        CU_ASSERT_EQUAL(list.head->msgid, GPSDATA_MSGID_GPGGA);
+        CU_ASSERT_EQUAL(list.tail->msgid, GPSDATA_MSGID_PGTOP);
+        CU_ASSERT_EQUAL(list.tail->fused_msgids, 0);
+    }
+    gpsdata_list_clear(&list);
+
+    // disabling fusion delivers the open epoch instead of dropping it
+    CU_ASSERT_EQUAL(gpsdata_parser_set_fusion(fsm, true, 0), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, epoch1, strlen(epoch1), &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_fusion(fsm, false, 0), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_flush(fsm, &list), 1);
+    CU_ASSERT_EQUAL(list.count, 1);
+    if (list.count == 1) {
+        CU_ASSERT_EQUAL(list.head->fused_msgids,
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGGA) |
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPGSA) |
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPRMC) |
+                GPSDATA_MSGID_MASK(GPSDATA_MSGID_GPVTG));
+    }
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, epoch2, strlen(epoch2), &list, &onum), 0);
+    CU_ASSERT_EQUAL(onum, 1);
+    if (onum == 1)
+        CU_ASSERT_EQUAL(list.tail->fused_msgids, 0);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+}
+
+#define TEST_RING_FIXES 100000
+
+static void *test_ring_producer(void *arg)
+{
+    gpsdata_ring_t *ring = (gpsdata_ring_t *)arg;
+    gpsdata_fix_t batch[7];
+    int64_t next = 1;
+    while (next <= TEST_RING_FIXES) {
+        size_t count = 0;
+        for (; count < 7 && next <= TEST_RING_FIXES; ++count)
+            batch[count].timestamp_usec = next++;
+        gpsdata_ring_push(ring, batch, count);
+    }
+    return NULL;
+}
+
+void test_ring()
+{
+    const char *gprmc =
+        "$GPRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2C\n"
+        "$GPRMC,064952.000,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A*2F\n";
+    gpsdata_fix_t fixes[8];
+    gpsdata_data_t *outp = NULL;
+    gpsdata_ring_t *ring = gpsdata_ring_create(3, true);
+    CU_ASSERT_PTR_NOT_NULL(ring);
+    if (!ring)
+        return;
+    CU_ASSERT(gpsdata_ring_fd(ring) >= 0);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT(gpsdata_parser_parse(fsm, gprmc, strlen(gprmc), &outp, NULL) >= 0);
+    CU_ASSERT_EQUAL(gpsdata_ring_push_list(ring, outp), 2);
+    CU_ASSERT_EQUAL(gpsdata_ring_pop(ring, fixes, 8), 2);
+    CU_ASSERT_EQUAL(fixes[0].msgid, GPSDATA_MSGID_GPRMC);
+    CU_ASSERT_EQUAL(fixes[0].latitude_e7, 231187600);
+    CU_ASSERT_EQUAL(fixes[1].timestamp_usec, fixes[0].timestamp_usec + 1000000);
+    CU_ASSERT_EQUAL(gpsdata_ring_pop(ring, fixes, 8), 0);
+    // the capacity was rounded up to 4, the rest are overruns
+    for (int i = 0; i < 3; ++i)
+        gpsdata_ring_push_list(ring, outp);
+    CU_ASSERT_EQUAL(gpsdata_ring_overruns(ring), 2);
+    CU_ASSERT_EQUAL(gpsdata_ring_pop(ring, fixes, 8), 4);
+    gpsdata_list_free(&outp);
+    gpsdata_parser_free(fsm);
+    gpsdata_ring_free(ring);
+
+    // every fix is either received in order or counted as an overrun
+    ring = gpsdata_ring_create(64, false);
+    CU_ASSERT_PTR_NOT_NULL(ring);
+    if (!ring)
+        return;
+    CU_ASSERT_EQUAL(gpsdata_ring_fd(ring), -1);
+    pthread_t thread;
+    CU_ASSERT_EQUAL(pthread_create(&thread, NULL, test_ring_producer, ring), 0);
+    int64_t last = 0;
+    uint64_t received = 0;
+    bool ordered = true;
+    while (received + gpsdata_ring_overruns(ring) < TEST_RING_FIXES) {
+        size_t n = gpsdata_ring_pop(ring, fixes, 8);
+        for (size_t i = 0; i < n; ++i) {
+            if (fixes[i].timestamp_usec <= last)
+                ordered = false;
+            last = fixes[i].timestamp_usec;
+        }
+        received += n;
+    }
+    pthread_join(thread, NULL);
+    received += gpsdata_ring_pop(ring, fixes, 8);
+    CU_ASSERT(ordered);
+    CU_ASSERT_EQUAL(received + gpsdata_ring_overruns(ring), TEST_RING_FIXES);
+    gpsdata_ring_free(ring);
+}
+
+#define TEST_LATEST_UPDATES 200000
+
+static void *test_latest_writer(void *arg)
+{
+    gpsdata_latest_t *latest = (gpsdata_latest_t *)arg;
+    gpsdata_data_t item;
+    gpsdata_initialize(&item);
+    item.msgid = GPSDATA_MSGID_GPGGA;
+    for (int32_t i = 1; i <= TEST_LATEST_UPDATES; ++i) {
+        item.latitude_e7 = i;
+        item.longitude_e7 = -i;
+        item.altitude_mm = i;
+        gpsdata_latest_update(latest, &item);
+    }
+    return NULL;
+}
+
+void test_latest()
+{
+    const char *buf =
+        "$GPGGA,185916.000,4048.5993,N,07418.5416,W,1,07,1.09,107.2,M,-34.2,M,,*5D\r\n"
+        "$PGTOP,11,3*6F\r\n"
+        "$GPVTG,7.37,T,,M,1.10,N,2.04,K,A*38\r\n";
+    gpsdata_latest_snapshot_t snap;
+    gpsdata_list_t list;
+    gpsdata_list_init(&list);
+    gpsdata_latest_t *latest = gpsdata_latest_create();
+    CU_ASSERT_PTR_NOT_NULL(latest);
+    if (!latest)
+        return;
+    CU_ASSERT_EQUAL(gpsdata_latest_read(latest, &snap), 0);
+    CU_ASSERT_EQUAL(snap.seq, 0);
+    CU_ASSERT_EQUAL(snap.position_rx_ms, 0);
+    gpsdata_parser_t *fsm = gpsdata_parser_create();
+    CU_ASSERT_PTR_NOT_NULL(fsm);
+    CU_ASSERT_EQUAL(gpsdata_parser_set_latest(fsm, latest), 0);
+    CU_ASSERT_EQUAL(gpsdata_parser_parse_list(fsm, buf, strlen(buf), &list, NULL), 0);
+    CU_ASSERT_EQUAL(gpsdata_latest_read(latest, &snap), 0);
+    CU_ASSERT_EQUAL(snap.seq, 3);
+    CU_ASSERT(snap.position_rx_ms > 0);
+    CU_ASSERT_EQUAL(snap.latitude_e7, 408099883);
+    CU_ASSERT_EQUAL(snap.num_satellites, 7);
+    CU_ASSERT_EQUAL(snap.altitude_mm, 107200);
+    CU_ASSERT_DOUBLE_EQUAL(snap.dop.hdop, 1.09, 0.001);
+    CU_ASSERT_EQUAL(snap.antenna_status, GPSDATA_ANTENNA_ACTIVE);
+    CU_ASSERT(snap.velocity_rx_ms >= snap.position_rx_ms);
+    CU_ASSERT_EQUAL(snap.speed_mmps, 566);
+    CU_ASSERT_EQUAL(snap.firmware_rx_ms, 0);
+    gpsdata_list_clear(&list);
+    gpsdata_parser_free(fsm);
+    gpsdata_latest_free(latest);
+
+    // a reader never sees the fields of two different updates
+    latest = gpsdata_latest_create();
+    CU_ASSERT_PTR_NOT_NULL(latest);
+    if (!latest)
+        return;
+    pthread_t thread;
+    CU_ASSERT_EQUAL(pthread_create(&thread, NULL, test_latest_writer, latest), 0);
+    bool consistent = true;
+    do {
+        gpsdata_latest_read(latest, &snap);
+        if (snap.seq > 0 && (snap.longitude_e7 != -snap.latitude_e7 ||
+                    snap.altitude_mm != snap.latitude_e7 ||
+                    snap.seq != (uint64_t)snap.latitude_e7))
+            consistent = false;
+    } while (snap.seq < TEST_LATEST_UPDATES);
+    pthread_join(thread, NULL);
+    CU_ASSERT(consistent);
+    gpsdata_latest_free(latest);
+}
+
 int main(int argc, char **argv)
 {
     int err = 0;
@@ -314,6 +1624,50 @@ int main(int argc, char **argv)
             break;
         if (!CU_ADD_TEST(suite, test_parse_gpvtg))
             break;
+        if (!CU_ADD_TEST(suite, test_parse_pool))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_cb))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_list))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_columns))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_columns_resume))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_fixed))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_filter))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_ack_filter))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_bad_checksum))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_resync))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_stats))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_rx_time))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_logsink))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_generator))
+            break;
+        if (!CU_ADD_TEST(suite, test_parse_fusion))
+            break;
+        if (!CU_ADD_TEST(suite, test_ring))
+            break;
+        if (!CU_ADD_TEST(suite, test_latest))
+            break;
+        if (!CU_ADD_TEST(suite, test_device_fix_interval))
+            break;
+        if (!CU_ADD_TEST(suite, test_device_negotiate))
+            break;
+        if (!CU_ADD_TEST(suite, test_device_cmdq))
+            break;
+        if (!CU_ADD_TEST(suite, test_device_cmdq_reentrant))
+            break;
+        if (!CU_ADD_TEST(suite, test_device_writer))
+            break;
         /* set the mode of
          * the test run in
          * debug/release
@@ -35,6 +35,30 @@ void test_timeval()
     CU_ASSERT_EQUAL(tv.tv_usec, 0);
 }
 
+void test_day_epoch()
+{
+    struct tm tm0 = { 0 };
+    struct timeval tv = { 0 };
+    // 29th February 2000
+    tm0.tm_year = 100;
+    tm0.tm_mon = 1;
+    tm0.tm_mday = 29;
+    CU_ASSERT_EQUAL(gpsutils_get_day_epoch(&tm0), 951782400);
+    // 13th month normalizes into the next year: 1st January 2001
+    tm0.tm_mon = 12;
+    tm0.tm_mday = 1;
+    CU_ASSERT_EQUAL(gpsutils_get_day_epoch(&tm0), 978307200);
+    // no date at all is the day before 1st January 1900
+    memset(&tm0, 0, sizeof(tm0));
+    CU_ASSERT_EQUAL(gpsutils_get_day_epoch(&tm0), -2209075200LL);
+    tm0.tm_hour = 18;
+    tm0.tm_min = 59;
+    tm0.tm_sec = 16;
+    CU_ASSERT_EQUAL(gpsutils_get_timeval_day(1586044800, &tm0, 250, &tv), 0);
+    CU_ASSERT_EQUAL(tv.tv_sec, 1586044800 + 18 * 3600 + 59 * 60 + 16);
+    CU_ASSERT_EQUAL(tv.tv_usec, 250000);
+}
+
 void test_hex_parse()
 {
     const char buf[16] = {
@@ -99,6 +123,95 @@ void test_checksum()
     CU_ASSERT_EQUAL(gpsutils_checksum("PMTK102", -1), 0x31);
 }
 
+void test_checksum_verify()
+{
+    char buf[512];
+    // compare against a plain loop for all lengths and alignments
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = (char)((i * 131 + 7) & 0x7F);
+    for (size_t off = 0; off < 8; ++off) {
+        for (size_t len = 0; len + off <= 300; ++len) {
+            uint8_t x = 0;
+            for (size_t i = 0; i < len; ++i)
+                x ^= (uint8_t)buf[off + i];
+            CU_ASSERT_EQUAL(gpsutils_xor_bytes(buf + off, len), x);
+        }
+    }
+    const char *good = "$PMTK251,38400*27\r\n";
+    const char *bad = "$PMTK251,38400*28\r\n";
+    size_t mlen = 0;
+    CU_ASSERT_EQUAL(gpsutils_checksum_verify(good, strlen(good), &mlen), 1);
+    CU_ASSERT_EQUAL(mlen, 17);
+    CU_ASSERT_EQUAL(gpsutils_checksum_verify(bad, strlen(bad), &mlen), 0);
+    CU_ASSERT_EQUAL(mlen, 17);
+    // the checksum digits have not arrived
+    CU_ASSERT_EQUAL(gpsutils_checksum_verify(good, 16, &mlen), -1);
+    CU_ASSERT_EQUAL(gpsutils_checksum_verify(good, 10, NULL), -1);
+    CU_ASSERT_EQUAL(gpsutils_checksum_verify(good + 1, 16, NULL), -1);
+    // the '*' of the next message is not used
+    const char *trunc = "$PMTK251,38\r\n$PMTK251,38400*27\r\n";
+    CU_ASSERT_EQUAL(gpsutils_checksum_verify(trunc, strlen(trunc), NULL), -1);
+}
+
+typedef struct {
+    size_t count;
+    char last[128];
+} test_log_capture_t;
+
+static void test_log_capture(void *ctx, int level, const char *fmt,
+                const char *msg, size_t len)
+{
+    test_log_capture_t *cap = (test_log_capture_t *)ctx;
+    CU_ASSERT_PTR_NOT_NULL(fmt);
+    CU_ASSERT(level >= GPSUTILS_LOGLEVEL_ERROR && level <= GPSUTILS_LOGLEVEL_DEBUG);
+    cap->count++;
+    if (len >= sizeof(cap->last))
+        len = sizeof(cap->last) - 1;
+    memcpy(cap->last, msg, len);
+    cap->last[len] = '\0';
+}
+
+void test_log_sink()
+{
+    test_log_capture_t cap = { 0 };
+    gpsutils_logsink_t sink = { test_log_capture, &cap };
+    gpsutils_log_printf(&sink, NULL, GPSUTILS_LOGLEVEL_WARN, NULL, 0, "value %d\n", 42);
+    CU_ASSERT_EQUAL(cap.count, 1);
+    CU_ASSERT_STRING_EQUAL(cap.last, "WARN: value 42\n");
+
+    // the first 3 messages from a call site pass through
+    memset(&cap, 0, sizeof(cap));
+    gpsutils_lograte_t *rl = gpsutils_lograte_create(&sink, 3, 60000);
+    CU_ASSERT_PTR_NOT_NULL(rl);
+    for (int i = 0; i < 10; ++i) {
+        gpsutils_log_printf(gpsutils_lograte_sink(rl), NULL, GPSUTILS_LOGLEVEL_WARN,
+                NULL, 0, "repeated %d\n", i);
+    }
+    gpsutils_log_printf(gpsutils_lograte_sink(rl), NULL, GPSUTILS_LOGLEVEL_WARN,
+            NULL, 0, "another site\n");
+    CU_ASSERT_EQUAL(cap.count, 4);
+    // the suppressed count is reported on free
+    gpsutils_lograte_free(rl);
+    CU_ASSERT_EQUAL(cap.count, 5);
+    CU_ASSERT_PTR_NOT_NULL(strstr(cap.last, "suppressed 7"));
+
+    char *buf = calloc(4096, sizeof(char));
+    CU_ASSERT_PTR_NOT_NULL(buf);
+    FILE *mem = fmemopen(buf, 4096, "w");
+    CU_ASSERT_PTR_NOT_NULL(mem);
+    gpsutils_logring_t *ring = gpsutils_logring_create(8, mem);
+    CU_ASSERT_PTR_NOT_NULL(ring);
+    for (int i = 0; i < 4; ++i) {
+        gpsutils_log_printf(gpsutils_logring_sink(ring), NULL, GPSUTILS_LOGLEVEL_INFO,
+                NULL, 0, "ring %d\n", i);
+    }
+    // the ring is drained before it is freed
+    gpsutils_logring_free(ring);
+    fclose(mem);
+    CU_ASSERT_STRING_EQUAL(buf, "INFO: ring 0\nINFO: ring 1\nINFO: ring 2\nINFO: ring 3\n");
+    GPSUTILS_FREE(buf);
+}
+
 int main(int argc, char **argv)
 {
     int err = 0;
@@ -119,6 +232,8 @@ int main(int argc, char **argv)
         }
         if (!CU_ADD_TEST(suite, test_timeval))
             break;
+        if (!CU_ADD_TEST(suite, test_day_epoch))
+            break;
         if (!CU_ADD_TEST(suite, test_hex_parse))
             break;
         if (!CU_ADD_TEST(suite, test_str_toupper))
@@ -127,6 +242,10 @@ int main(int argc, char **argv)
             break;
         if (!CU_ADD_TEST(suite, test_checksum))
             break;
+        if (!CU_ADD_TEST(suite, test_checksum_verify))
+            break;
+        if (!CU_ADD_TEST(suite, test_log_sink))
+            break;
         /* set the mode of the test run in
          * debug/release mode*/
         CU_basic_set_mode(CU_BRM_VERBOSE);